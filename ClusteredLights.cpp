@@ -0,0 +1,187 @@
+#include "ClusteredLights.h"
+#include "FrameData.h"
+#include "FrameStats.h"
+#include "GlErrors.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+ClusteredLights::~ClusteredLights()
+{
+    glDeleteTextures(3, m_textures);
+    glDeleteBuffers(3, m_buffers);
+}
+
+bool ClusteredLights::init()
+{
+    const GLenum formats[3] = { GL_RGBA32F, GL_RG32UI, GL_R16UI };
+    ClearGlErrors("ClusteredLights::init");
+    glGenBuffers(3, m_buffers);
+    glGenTextures(3, m_textures);
+    for (int i = 0; i < 3; ++i) {
+        glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[i]);
+        glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, m_textures[i]);
+        glTexBuffer(GL_TEXTURE_BUFFER, formats[i], m_buffers[i]);
+    }
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    m_grid.assign(kClusterCount * 2, 0);
+    m_sliceIndices.resize(kSlices);
+    return glGetError() == GL_NO_ERROR;
+}
+
+void ClusteredLights::buildClusterBounds(const glm::mat4& projection, float nearPlane, float farPlane)
+{
+    m_boundsProjection = projection;
+    m_nearPlane = nearPlane;
+    m_farPlane = farPlane;
+    for (int s = 0; s <= kSlices; ++s)
+        m_sliceDepth[s] = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(s) / kSlices);
+
+    // Tile corners as view-space directions scaled to depth 1.
+    const glm::mat4 invProjection = glm::inverse(projection);
+    std::vector<glm::vec3> corners((kTilesX + 1) * (kTilesY + 1));
+    for (int y = 0; y <= kTilesY; ++y) {
+        for (int x = 0; x <= kTilesX; ++x) {
+            glm::vec4 ndc(-1.0f + 2.0f * x / kTilesX, -1.0f + 2.0f * y / kTilesY, -1.0f, 1.0f);
+            glm::vec4 p = invProjection * ndc;
+            glm::vec3 v = glm::vec3(p) / p.w;
+            corners[y * (kTilesX + 1) + x] = v / -v.z;
+        }
+    }
+
+    m_bounds.resize(kClusterCount);
+    for (int s = 0; s < kSlices; ++s) {
+        for (int y = 0; y < kTilesY; ++y) {
+            for (int x = 0; x < kTilesX; ++x) {
+                Aabb box = { glm::vec3(1e30f), glm::vec3(-1e30f) };
+                for (int c = 0; c < 4; ++c) {
+                    const glm::vec3& dir = corners[(y + c / 2) * (kTilesX + 1) + x + c % 2];
+                    for (float depth : { m_sliceDepth[s], m_sliceDepth[s + 1] }) {
+                        box.min = glm::min(box.min, dir * depth);
+                        box.max = glm::max(box.max, dir * depth);
+                    }
+                }
+                m_bounds[(s * kTilesY + y) * kTilesX + x] = box;
+            }
+        }
+    }
+}
+
+void ClusteredLights::binSlice(int slice)
+{
+    std::vector<uint16_t>& out = m_sliceIndices[slice];
+    out.clear();
+
+    // Depth pre-pass over the lights keeps the per-cluster tests to the lights that can reach this slice.
+    uint16_t candidates[kMaxLights];
+    int candidateCount = 0;
+    const float sliceNear = m_sliceDepth[slice];
+    const float sliceFar = m_sliceDepth[slice + 1];
+    for (int i = 0; i < m_lightCount; ++i) {
+        const glm::vec4& light = m_viewLights[i];
+        float depth = -light.z;
+        if (depth + light.w >= sliceNear && depth - light.w <= sliceFar)
+            candidates[candidateCount++] = static_cast<uint16_t>(i);
+    }
+
+    const int first = slice * kTilesX * kTilesY;
+    for (int tile = 0; tile < kTilesX * kTilesY; ++tile) {
+        const Aabb& box = m_bounds[first + tile];
+        const uint32_t offset = static_cast<uint32_t>(out.size());
+        for (int c = 0; c < candidateCount; ++c) {
+            const glm::vec4& light = m_viewLights[candidates[c]];
+            glm::vec3 center(light);
+            glm::vec3 closest = glm::clamp(center, box.min, box.max);
+            glm::vec3 d = center - closest;
+            if (glm::dot(d, d) <= light.w * light.w) out.push_back(candidates[c]);
+        }
+        // Offsets are slice-local here; update() rebases them once every slice is done.
+        m_grid[(first + tile) * 2] = offset;
+        m_grid[(first + tile) * 2 + 1] = static_cast<uint32_t>(out.size()) - offset;
+    }
+}
+
+void ClusteredLights::update(const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection,
+    float nearPlane, float farPlane)
+{
+    PROFILE_SCOPE("Light binning");
+    auto start = std::chrono::steady_clock::now();
+
+    if (projection != m_boundsProjection || nearPlane != m_nearPlane || farPlane != m_farPlane || m_bounds.empty())
+        buildClusterBounds(projection, nearPlane, farPlane);
+
+    m_lightCount = static_cast<int>(std::min<size_t>(lights.size(), kMaxLights));
+    m_viewLights.resize(m_lightCount);
+    m_lightTexels.assign(std::max(m_lightCount, 1) * 2, glm::vec4(0.0f));     // never upload an empty buffer
+    for (int i = 0; i < m_lightCount; ++i) {
+        const PointLight& light = lights[i];
+        m_viewLights[i] = glm::vec4(glm::vec3(view * glm::vec4(light.position, 1.0f)), light.radius);
+        m_lightTexels[i * 2] = glm::vec4(light.position, light.radius);
+        m_lightTexels[i * 2 + 1] = glm::vec4(light.color, 0.0f);
+    }
+
+    jobSystem.parallelFor(kSlices, 1, [this](size_t begin, size_t end) {
+        for (size_t s = begin; s < end; ++s) binSlice(static_cast<int>(s));
+    });
+
+    // Concatenate the slice lists and rebase the grid offsets.
+    m_indices.clear();
+    m_maxPerCluster = 0;
+    for (int s = 0; s < kSlices; ++s) {
+        const uint32_t base = static_cast<uint32_t>(m_indices.size());
+        m_indices.insert(m_indices.end(), m_sliceIndices[s].begin(), m_sliceIndices[s].end());
+        const int first = s * kTilesX * kTilesY;
+        for (int tile = 0; tile < kTilesX * kTilesY; ++tile) {
+            m_grid[(first + tile) * 2] += base;
+            m_maxPerCluster = std::max(m_maxPerCluster, m_grid[(first + tile) * 2 + 1]);
+        }
+    }
+    if (m_indices.empty()) m_indices.push_back(0);     // keep the buffer non-empty
+
+    // Re-specifying each store orphans last frame's copy instead of waiting for the GPU.
+    const void* data[3] = { m_lightTexels.data(), m_grid.data(), m_indices.data() };
+    const size_t sizes[3] = {
+        m_lightTexels.size() * sizeof(glm::vec4),
+        m_grid.size() * sizeof(uint32_t),
+        m_indices.size() * sizeof(uint16_t) };
+    for (int i = 0; i < 3; ++i) {
+        glBindBuffer(GL_TEXTURE_BUFFER, m_buffers[i]);
+        glBufferData(GL_TEXTURE_BUFFER, sizes[i], data[i], GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    frameStats.glCalls += 7;
+
+    m_binMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ClusteredLights::bindTextures() const
+{
+    const GLenum units[3] = { kClusterLightsUnit, kClusterGridUnit, kClusterIndexUnit };
+    for (int i = 0; i < 3; ++i) {
+        glActiveTexture(GL_TEXTURE0 + units[i]);
+        glBindTexture(GL_TEXTURE_BUFFER, m_textures[i]);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    frameStats.glCalls += 7;
+    frameStats.textureBinds += 3;
+}
+
+glm::vec4 ClusteredLights::sizeParams() const
+{
+    return glm::vec4(kTilesX, kTilesY, kSlices, static_cast<float>(m_lightCount));
+}
+
+glm::vec4 ClusteredLights::sliceParams(int width, int height) const
+{
+    // slice = log(depth) * scale + bias, the inverse of m_sliceDepth.
+    const float logRange = std::log(m_farPlane / m_nearPlane);
+    const float scale = kSlices / logRange;
+    const float bias = -kSlices * std::log(m_nearPlane) / logRange;
+    return glm::vec4(scale, bias, static_cast<float>(width) / kTilesX, static_cast<float>(height) / kTilesY);
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+struct PointLight {
+    glm::vec3 position;     // world space
+    float radius;           // contribution fades to zero here
+    glm::vec3 color;        // premultiplied by intensity
+};
+
+// Clustered forward lighting: the view frustum is split into kTilesX x kTilesY screen tiles
+// and kSlices exponential depth slices. Every frame the point lights are binned into the
+// clusters they touch on the JobSystem, and three buffer textures are uploaded for the
+// CLUSTERED shader variant: light data, a per-cluster (offset, count) grid and the
+// light index lists the grid points into.
+class ClusteredLights
+{
+public:
+    static constexpr int kTilesX = 16;
+    static constexpr int kTilesY = 9;
+    static constexpr int kSlices = 24;
+    static constexpr int kClusterCount = kTilesX * kTilesY * kSlices;
+    static constexpr int kMaxLights = 4096;
+
+    ClusteredLights() = default;
+    ~ClusteredLights();
+    ClusteredLights(const ClusteredLights&) = delete;
+    ClusteredLights& operator=(const ClusteredLights&) = delete;
+
+    bool init();
+
+    // Bins `lights` for a perspective camera and uploads the result. Lights past kMaxLights are ignored.
+    void update(const std::vector<PointLight>& lights, const glm::mat4& view, const glm::mat4& projection,
+        float nearPlane, float farPlane);
+    void bindTextures() const;
+
+    // FrameData.clusterSize / clusterParams for a width x height render target.
+    glm::vec4 sizeParams() const;
+    glm::vec4 sliceParams(int width, int height) const;
+
+    int lightCount() const { return m_lightCount; }
+    size_t indexCount() const { return m_indices.size(); }
+    unsigned int maxLightsPerCluster() const { return m_maxPerCluster; }
+    double binMs() const { return m_binMs; }
+
+private:
+    struct Aabb {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    void buildClusterBounds(const glm::mat4& projection, float nearPlane, float farPlane);
+    void binSlice(int slice);
+
+    GLuint m_buffers[3] = {};       // lights, grid, indices
+    GLuint m_textures[3] = {};
+
+    // View-space cluster bounds, rebuilt when the projection changes.
+    std::vector<Aabb> m_bounds;
+    glm::mat4 m_boundsProjection = glm::mat4(0.0f);
+    float m_nearPlane = 0.0f;
+    float m_farPlane = 0.0f;
+    float m_sliceDepth[kSlices + 1] = {};
+
+    // Per-frame binning state
+    std::vector<glm::vec4> m_viewLights;        // view-space position, radius
+    std::vector<glm::vec4> m_lightTexels;       // 2 texels per light
+    std::vector<std::vector<uint16_t>> m_sliceIndices;
+    std::vector<uint32_t> m_grid;               // (offset, count) per cluster
+    std::vector<uint16_t> m_indices;
+    int m_lightCount = 0;
+    unsigned int m_maxPerCluster = 0;
+    double m_binMs = 0.0;
+};
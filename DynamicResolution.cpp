@@ -0,0 +1,54 @@
+#include "DynamicResolution.h"
+#include <algorithm>
+#include <cmath>
+
+void DynamicResolution::configure(float minScale, float maxScale, float targetMs)
+{
+    m_minScale = std::clamp(minScale, kStep, 1.0f);
+    m_maxScale = std::clamp(maxScale, m_minScale, 1.0f);
+    m_targetMs = std::max(targetMs, 0.1f);
+    m_scale = m_maxScale;
+}
+
+void DynamicResolution::update(bool enabled, double gpuMs)
+{
+    if (!enabled) {
+        m_scale = 1.0f;
+        m_samples = 0;
+        m_sumMs = 0.0;
+        return;
+    }
+    m_scale = std::clamp(m_scale, m_minScale, m_maxScale);
+    if (m_settle > 0) {
+        m_settle--;
+        return;
+    }
+    if (gpuMs < 0.0) return;
+
+    m_sumMs += gpuMs;
+    if (++m_samples < kSamplesPerAdjust) return;
+    m_averageMs = m_sumMs / m_samples;
+    m_samples = 0;
+    m_sumMs = 0.0;
+
+    // Drop as far as needed right away, but climb at most one step at a time and only with
+    // 10% headroom, so the scale does not bounce around the target.
+    float wanted = m_scale * static_cast<float>(std::sqrt(m_targetMs / m_averageMs));
+    float next = m_scale;
+    if (m_averageMs > m_targetMs)
+        next = std::floor(wanted / kStep) * kStep;
+    else if (m_averageMs < 0.9 * m_targetMs && wanted >= m_scale + kStep)
+        next = std::round(m_scale / kStep + 1.0f) * kStep;
+    next = std::clamp(next, m_minScale, m_maxScale);
+
+    if (std::fabs(next - m_scale) > 0.001f) {
+        m_scale = next;
+        m_settle = kSettleFrames;
+    }
+}
+
+void DynamicResolution::scaledSize(int width, int height, int& scaledWidth, int& scaledHeight) const
+{
+    scaledWidth = std::max(1, static_cast<int>(width * m_scale + 0.5f));
+    scaledHeight = std::max(1, static_cast<int>(height * m_scale + 0.5f));
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+// Picks the scene's render scale from measured GPU frame times. Every kSamplesPerAdjust
+// results the average is compared with the target: over it, the scale drops; comfortably
+// under it, the scale climbs back towards the maximum. GPU cost is taken to grow with the
+// pixel count, i.e. with scale squared.
+//
+// Scales are multiples of kStep so only a handful of target sizes ever get allocated, and
+// after a change results are ignored until frames rendered at the new size come back.
+class DynamicResolution
+{
+public:
+    static constexpr float kStep = 0.05f;
+    static constexpr int kSamplesPerAdjust = 8;
+    static constexpr int kSettleFrames = 4;     // GpuTimer latency
+
+    void configure(float minScale, float maxScale, float targetMs);
+
+    // Call once per rendered frame. `gpuMs` is the newest GPU frame time, or negative if
+    // none came back this frame. While disabled the scale is fixed at 1.
+    void update(bool enabled, double gpuMs);
+
+    float scale() const { return m_scale; }
+    float minScale() const { return m_minScale; }
+    float maxScale() const { return m_maxScale; }
+    float targetMs() const { return m_targetMs; }
+    // Average of the last complete window of samples; 0 before the first one.
+    double averageMs() const { return m_averageMs; }
+
+    // The width x height render size for an output of the given size.
+    void scaledSize(int width, int height, int& scaledWidth, int& scaledHeight) const;
+
+private:
+    float m_minScale = 0.5f;
+    float m_maxScale = 1.0f;
+    float m_targetMs = 16.0f;
+    float m_scale = 1.0f;
+    int m_settle = 0;
+    int m_samples = 0;
+    double m_sumMs = 0.0;
+    double m_averageMs = 0.0;
+};
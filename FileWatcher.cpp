@@ -0,0 +1,115 @@
+#include "FileWatcher.h"
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <map>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+FileWatcher::~FileWatcher()
+{
+    stop();
+}
+
+bool FileWatcher::start(const std::string& directory, std::function<void()> onChange)
+{
+    stop();
+    if (!std::filesystem::is_directory(directory)) {
+        std::cerr << "FileWatcher: not a directory: " << directory << "\n";
+        return false;
+    }
+    m_directory = directory;
+    m_onChange = std::move(onChange);
+    m_running = true;
+
+#if defined(__linux__)
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    // Editors often save by writing a temp file and renaming it over the original.
+    if (m_inotifyFd >= 0 && inotify_add_watch(m_inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) >= 0) {
+        m_thread = std::thread(&FileWatcher::runInotify, this);
+        return true;
+    }
+    if (m_inotifyFd >= 0) close(m_inotifyFd);
+    m_inotifyFd = -1;
+    std::cerr << "FileWatcher: inotify unavailable, polling " << directory << "\n";
+#endif
+    m_thread = std::thread(&FileWatcher::runPolling, this);
+    return true;
+}
+
+void FileWatcher::stop()
+{
+    if (!m_thread.joinable()) return;
+    m_running = false;
+    m_thread.join();
+#if defined(__linux__)
+    if (m_inotifyFd >= 0) close(m_inotifyFd);
+    m_inotifyFd = -1;
+#endif
+}
+
+std::vector<std::string> FileWatcher::takeChanges()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<std::string> changes(m_changes.begin(), m_changes.end());
+    m_changes.clear();
+    m_hasChanges.store(false, std::memory_order_release);
+    return changes;
+}
+
+void FileWatcher::report(const std::string& name)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_changes.insert(name);
+        m_hasChanges.store(true, std::memory_order_release);
+    }
+    if (m_onChange) m_onChange();
+}
+
+void FileWatcher::runInotify()
+{
+#if defined(__linux__)
+    alignas(inotify_event) char buffer[4096];
+    while (m_running) {
+        // Short timeout so stop() is honored promptly.
+        pollfd pfd = { m_inotifyFd, POLLIN, 0 };
+        if (poll(&pfd, 1, 200) <= 0) continue;
+
+        ssize_t length = read(m_inotifyFd, buffer, sizeof(buffer));
+        for (ssize_t offset = 0; offset < length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (event->len > 0 && !(event->mask & IN_ISDIR)) report(event->name);
+            offset += sizeof(inotify_event) + event->len;
+        }
+    }
+#endif
+}
+
+void FileWatcher::runPolling()
+{
+    std::map<std::string, std::filesystem::file_time_type> times;
+    auto scan = [&](bool notify) {
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(m_directory, ec)) {
+            if (!entry.is_regular_file(ec)) continue;
+            std::string name = entry.path().filename().string();
+            auto time = entry.last_write_time(ec);
+            auto it = times.find(name);
+            if (it == times.end() || it->second != time) {
+                times[name] = time;
+                if (notify) report(name);
+            }
+        }
+    };
+
+    scan(false);
+    while (m_running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        scan(true);
+    }
+}
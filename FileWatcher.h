@@ -0,0 +1,43 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Watches one directory on a background thread and collects the names of files that
+// were written or replaced. Uses inotify on Linux and falls back to polling
+// modification times elsewhere (or if inotify is unavailable).
+class FileWatcher
+{
+public:
+    FileWatcher() = default;
+    ~FileWatcher();
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // `onChange` runs on the watcher thread whenever something changed (e.g. to wake an idle loop).
+    bool start(const std::string& directory, std::function<void()> onChange = nullptr);
+    void stop();
+    bool running() const { return m_thread.joinable(); }
+
+    bool hasChanges() const { return m_hasChanges.load(std::memory_order_acquire); }
+    // Returns and clears the file names (relative to the directory) changed since the last call.
+    std::vector<std::string> takeChanges();
+
+private:
+    void runInotify();
+    void runPolling();
+    void report(const std::string& name);
+
+    std::string m_directory;
+    std::function<void()> m_onChange;
+    std::thread m_thread;
+    std::atomic<bool> m_running{ false };
+    std::atomic<bool> m_hasChanges{ false };
+    std::mutex m_mutex;
+    std::set<std::string> m_changes;
+    int m_inotifyFd = -1;
+};
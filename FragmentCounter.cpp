@@ -0,0 +1,50 @@
+#include "FragmentCounter.h"
+
+FragmentCounter::~FragmentCounter()
+{
+    if (m_queries[0]) glDeleteQueries(kLatency, m_queries);
+}
+
+bool FragmentCounter::init()
+{
+    glGenQueries(kLatency, m_queries);
+    return m_queries[0] != 0;
+}
+
+void FragmentCounter::collect(bool wait)
+{
+    while (m_pending > 0) {
+        GLuint query = m_queries[(m_next - m_pending + kLatency) % kLatency];
+        if (!wait) {
+            GLint available = 0;
+            glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) return;
+        }
+        GLuint64 samples = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &samples);
+        m_samples = samples;
+        m_pending--;
+        // Only the oldest query may block; the rest are picked up on later frames.
+        wait = false;
+    }
+}
+
+void FragmentCounter::begin()
+{
+    if (!m_queries[0] || m_active) return;
+    collect(false);
+    // Every slot still in flight: the GPU is over kLatency frames behind, so wait for the oldest.
+    if (m_pending == kLatency) collect(true);
+
+    glBeginQuery(GL_SAMPLES_PASSED, m_queries[m_next]);
+    m_active = true;
+}
+
+void FragmentCounter::end()
+{
+    if (!m_active) return;
+    glEndQuery(GL_SAMPLES_PASSED);
+    m_next = (m_next + 1) % kLatency;
+    m_pending++;
+    m_active = false;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstdint>
+
+// Counts the samples that pass the depth test between begin() and end() with
+// GL_SAMPLES_PASSED queries. Results are read back kLatency frames late at most,
+// so the CPU does not wait on the GPU to finish the counted draws.
+class FragmentCounter
+{
+public:
+    FragmentCounter() = default;
+    ~FragmentCounter();
+    FragmentCounter(const FragmentCounter&) = delete;
+    FragmentCounter& operator=(const FragmentCounter&) = delete;
+
+    bool init();
+
+    void begin();
+    void end();
+
+    // Newest result that has come back; 0 until the first one does.
+    uint64_t samples() const { return m_samples; }
+
+private:
+    static const int kLatency = 4;
+
+    void collect(bool wait);
+
+    GLuint m_queries[kLatency] = {};
+    int m_next = 0;         // slot the next begin() writes
+    int m_pending = 0;      // issued queries not read back yet, oldest at m_next - m_pending
+    bool m_active = false;
+    uint64_t m_samples = 0;
+};
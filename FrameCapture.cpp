@@ -0,0 +1,262 @@
+#include "FrameCapture.h"
+#include "ImageWriter.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+
+FrameCapture::~FrameCapture()
+{
+    shutdown();
+}
+
+void FrameCapture::init(const std::string& outputDir, int fps)
+{
+    m_outputDir = outputDir;
+    m_fps = fps > 0 ? fps : 60;
+    if (!m_worker.joinable()) {
+        m_quit = false;
+        m_worker = std::thread(&FrameCapture::workerMain, this);
+    }
+}
+
+void FrameCapture::shutdown()
+{
+    if (!m_worker.joinable()) return;
+    m_mode = Mode::Off;
+    drain();
+    closeVideo();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_cv.notify_one();
+    m_worker.join();
+
+    for (Slot& slot : m_slots) {
+        if (slot.pbo) glDeleteBuffers(1, &slot.pbo);
+        slot.pbo = 0;
+    }
+    m_bufferWidth = m_bufferHeight = 0;
+}
+
+std::string FrameCapture::nextPath(const char* prefix, const char* extension)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(m_outputDir, ec);
+    char name[64];
+    std::snprintf(name, sizeof(name), "%s_%04d.%s", prefix, m_counter++, extension);
+    return (std::filesystem::path(m_outputDir) / name).string();
+}
+
+void FrameCapture::takeScreenshot()
+{
+    if (m_mode == Mode::Off) m_mode = Mode::Screenshot;
+}
+
+void FrameCapture::startPngSequence()
+{
+    stop();
+    m_mode = Mode::PngSequence;
+}
+
+void FrameCapture::startVideo()
+{
+    stop();
+    m_videoPath = nextPath("capture", "y4m");
+    m_mode = Mode::Video;
+}
+
+void FrameCapture::stop()
+{
+    // Frames already in flight are still written; the stream is closed once they are.
+    if (m_mode == Mode::Video || m_mode == Mode::PngSequence) m_mode = Mode::Off;
+}
+
+bool FrameCapture::busy() const
+{
+    if (m_mode != Mode::Off) return true;
+    for (const Slot& slot : m_slots) {
+        if (slot.state != SlotState::Free) return true;
+    }
+    return false;
+}
+
+size_t FrameCapture::queuedFrames() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_jobs.size();
+}
+
+void FrameCapture::update(bool wait)
+{
+    // Oldest first, so frames reach the worker (and the video stream) in order.
+    for (int i = 0; i < kRingSize; ++i) {
+        Slot& slot = m_slots[(m_next + i) % kRingSize];
+
+        if (slot.state == SlotState::Encoding && slot.encoded.load(std::memory_order_acquire)) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            slot.state = SlotState::Free;
+        }
+
+        if (slot.state == SlotState::Reading) {
+            GLenum status = glClientWaitSync(slot.fence, 0, 0);
+            if (status == GL_TIMEOUT_EXPIRED) {
+                if (!wait) break;   // later slots were issued after this one
+                glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            }
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+
+            const GLsizeiptr bytes = static_cast<GLsizeiptr>(slot.width) * slot.height * 4;
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+            const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+            if (data) {
+                slot.encoded.store(false, std::memory_order_relaxed);
+                slot.state = SlotState::Encoding;
+                pushJob({ &slot, static_cast<const unsigned char*>(data) });
+            }
+            else {
+                slot.state = SlotState::Free;
+                m_framesDropped++;
+            }
+        }
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void FrameCapture::drain()
+{
+    update(true);
+    for (;;) {
+        bool encoding = false;
+        for (const Slot& slot : m_slots) encoding |= slot.state == SlotState::Encoding;
+        if (!encoding) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        update(true);
+    }
+}
+
+void FrameCapture::closeVideo()
+{
+    if (m_videoPath.empty()) return;
+    pushJob(Job());
+    m_videoPath.clear();
+}
+
+void FrameCapture::ensureBuffers(int width, int height)
+{
+    if (width == m_bufferWidth && height == m_bufferHeight) return;
+
+    // Size change: finish what is in flight with the old buffers first.
+    drain();
+    const GLsizeiptr bytes = static_cast<GLsizeiptr>(width) * height * 4;
+    for (Slot& slot : m_slots) {
+        if (!slot.pbo) glGenBuffers(1, &slot.pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    m_bufferWidth = width;
+    m_bufferHeight = height;
+}
+
+void FrameCapture::captureFrame(GLuint framebuffer, int width, int height)
+{
+    if (!busy()) {
+        closeVideo();
+        return;
+    }
+
+    PROFILE_SCOPE("FrameCapture::captureFrame");
+    auto start = std::chrono::steady_clock::now();
+
+    update(false);
+
+    if (m_mode != Mode::Off) {
+        ensureBuffers(width, height);
+        Slot& slot = m_slots[m_next];
+        if (slot.state != SlotState::Free) {
+            // GPU or worker is kRingSize frames behind; skip rather than wait.
+            m_framesDropped++;
+        }
+        else {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+            glReadBuffer(framebuffer ? GL_COLOR_ATTACHMENT0 : GL_BACK);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            slot.state = SlotState::Reading;
+            slot.mode = m_mode;
+            slot.width = width;
+            slot.height = height;
+            if (m_mode == Mode::Video) slot.path = m_videoPath;
+            else slot.path = nextPath(m_mode == Mode::Screenshot ? "screenshot" : "frame", "png");
+            m_next = (m_next + 1) % kRingSize;
+            if (m_mode == Mode::Screenshot) m_mode = Mode::Off;
+        }
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    m_lastCostMs = ms;
+    m_totalCostMs += ms;
+    m_costSamples++;
+    m_maxCostMs = std::max(m_maxCostMs, ms);
+}
+
+void FrameCapture::pushJob(const Job& job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(job);
+    }
+    m_cv.notify_one();
+}
+
+void FrameCapture::workerMain()
+{
+    Y4MWriter video;
+    std::string videoPath;
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_quit || !m_jobs.empty(); });
+            if (m_jobs.empty()) break;  // quit requested and nothing left to write
+            job = m_jobs.front();
+            m_jobs.pop_front();
+        }
+
+        if (!job.slot) {
+            video.close();
+            videoPath.clear();
+            continue;
+        }
+
+        Slot& slot = *job.slot;
+        bool ok = false;
+        if (slot.mode == Mode::Video) {
+            if (slot.path != videoPath) {
+                videoPath = slot.path;
+                if (video.open(videoPath, slot.width, slot.height, m_fps))
+                    std::cout << "Recording video to " << videoPath << "\n";
+            }
+            // The stream's size is fixed when it is opened; frames of another size are skipped.
+            if (video.isOpen() && (slot.width & ~1) == video.width() && (slot.height & ~1) == video.height())
+                ok = video.writeFrame(job.pixels, true);
+        }
+        else {
+            ok = WritePNG(slot.path, slot.width, slot.height, 4, job.pixels, true);
+            if (ok && slot.mode == Mode::Screenshot) std::cout << "Saved screenshot " << slot.path << "\n";
+        }
+        if (ok) m_framesWritten++;
+        else m_framesDropped++;
+        slot.encoded.store(true, std::memory_order_release);
+    }
+    video.close();
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <GL/glew.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Asynchronous screenshot/video capture. Each captured frame is read into one of
+// kRingSize pixel buffer objects. A few frames later, once its fence has signaled,
+// the buffer is mapped and the worker thread encodes PNG or appends to a Y4M stream
+// straight from the mapping; the render thread unmaps it after the worker is done.
+// The render thread never waits on the GPU, on encoding or on disk: if every buffer
+// is still busy the frame is dropped.
+class FrameCapture
+{
+public:
+    enum class Mode { Off, Screenshot, PngSequence, Video };
+
+    static const int kRingSize = 4;
+
+    FrameCapture() = default;
+    ~FrameCapture();
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    // Starts the worker; captures are written under `outputDir`.
+    void init(const std::string& outputDir, int fps);
+    // Finishes everything in flight (this one does block), stops the worker and frees GL objects.
+    void shutdown();
+
+    // A screenshot request is ignored while a recording is running.
+    void takeScreenshot();
+    void startPngSequence();
+    void startVideo();
+    void stop();
+    Mode mode() const { return m_mode; }
+    // True while capturing or while frames are still in flight; frames must keep coming until then.
+    bool busy() const;
+
+    // Call once per frame after the scene is drawn, with the framebuffer to read (0 = back buffer).
+    void captureFrame(GLuint framebuffer, int width, int height);
+
+    // Render-thread cost of captureFrame() while busy, in milliseconds.
+    double lastCostMs() const { return m_lastCostMs; }
+    double averageCostMs() const { return m_costSamples ? m_totalCostMs / m_costSamples : 0.0; }
+    double maxCostMs() const { return m_maxCostMs; }
+    unsigned int framesWritten() const { return m_framesWritten.load(); }
+    unsigned int framesDropped() const { return m_framesDropped.load(); }
+    size_t queuedFrames() const;
+
+private:
+    enum class SlotState { Free, Reading, Encoding };
+
+    struct Slot {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        SlotState state = SlotState::Free;
+        std::atomic<bool> encoded{ false };     // set by the worker when it is done with the mapping
+        Mode mode = Mode::Off;
+        int width = 0;
+        int height = 0;
+        std::string path;
+    };
+
+    struct Job {
+        Slot* slot = nullptr;                   // nullptr: close the video stream
+        const unsigned char* pixels = nullptr;
+    };
+
+    void update(bool wait);
+    void drain();
+    void ensureBuffers(int width, int height);
+    void closeVideo();
+    void pushJob(const Job& job);
+    void workerMain();
+    std::string nextPath(const char* prefix, const char* extension);
+
+    Slot m_slots[kRingSize];
+    int m_next = 0;
+    int m_bufferWidth = 0;
+    int m_bufferHeight = 0;
+    Mode m_mode = Mode::Off;
+    std::string m_outputDir;
+    std::string m_videoPath;
+    int m_fps = 60;
+    int m_counter = 0;
+
+    double m_lastCostMs = 0.0;
+    double m_totalCostMs = 0.0;
+    unsigned int m_costSamples = 0;
+    double m_maxCostMs = 0.0;
+
+    std::thread m_worker;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<Job> m_jobs;
+    bool m_quit = false;
+    std::atomic<unsigned int> m_framesWritten{ 0 };
+    std::atomic<unsigned int> m_framesDropped{ 0 };
+};
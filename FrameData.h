@@ -0,0 +1,35 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// CPU mirror of the std140 "FrameData" uniform block declared in the shaders.
+// vec3 values are stored as vec4 so the C++ layout matches std140 padding.
+struct FrameData
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec4 lightDir;     // xyz = direction towards the light
+    glm::vec4 lightColor;   // xyz = color premultiplied by intensity
+    glm::vec4 viewPos;      // xyz = camera position
+    float time;
+    float pad[3];
+
+    // Cascaded shadow map (see ShadowMap)
+    glm::mat4 lightSpace[4];
+    glm::vec4 cascadeSplits;    // far view depth of each cascade
+    glm::vec4 shadowParams;     // x = cascade count (0 disables), y = PCF radius, z = 1 / resolution
+
+    // Clustered point lights (see ClusteredLights)
+    glm::vec4 clusterSize;      // xy = screen tiles, z = depth slices, w = light count
+    glm::vec4 clusterParams;    // slice = log(view depth) * x + y; zw = tile size in pixels
+};
+
+// Uniform buffer binding point the FrameData block is attached to.
+constexpr unsigned int kFrameDataBinding = 0;
+
+// Texture unit the shadow map array is bound to while shading.
+constexpr unsigned int kShadowMapUnit = 1;
+
+// Texture units of the clustered lighting buffer textures.
+constexpr unsigned int kClusterLightsUnit = 2;
+constexpr unsigned int kClusterGridUnit = 3;
+constexpr unsigned int kClusterIndexUnit = 4;
@@ -0,0 +1,334 @@
+#include "FrameGraph.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+
+static const char* formatName(GLenum format)
+{
+    switch (format) {
+    case GL_RGBA8: return "RGBA8";
+    case GL_RGBA16F: return "RGBA16F";
+    case GL_RGBA32F: return "RGBA32F";
+    case GL_R11F_G11F_B10F: return "R11G11B10F";
+    case GL_RG16F: return "RG16F";
+    case GL_R16F: return "R16F";
+    case GL_R8: return "R8";
+    case GL_DEPTH_COMPONENT24: return "DEPTH24";
+    default: return "?";
+    }
+}
+
+static double megabytes(size_t bytes)
+{
+    return bytes / (1024.0 * 1024.0);
+}
+
+FrameGraphResource FrameGraph::Builder::create(const char* name, const RenderTargetDesc& desc)
+{
+    Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    m_graph.m_resources.push_back(resource);
+    FrameGraphResource handle = static_cast<FrameGraphResource>(m_graph.m_resources.size() - 1);
+    m_graph.m_passes[m_pass].creates.push_back(handle);
+    return write(handle);
+}
+
+FrameGraphResource FrameGraph::Builder::read(FrameGraphResource resource)
+{
+    if (resource == kNoResource) return resource;
+    m_graph.m_passes[m_pass].reads.push_back(resource);
+    m_graph.m_resources[resource].readers.push_back(m_pass);
+    return resource;
+}
+
+FrameGraphResource FrameGraph::Builder::write(FrameGraphResource resource)
+{
+    if (resource == kNoResource) return resource;
+    m_graph.m_passes[m_pass].writes.push_back(resource);
+    m_graph.m_resources[resource].writers.push_back(m_pass);
+    return resource;
+}
+
+void FrameGraph::Builder::setExecute(Execute execute)
+{
+    m_graph.m_passes[m_pass].execute = std::move(execute);
+}
+
+void FrameGraph::reset()
+{
+    m_resources.clear();
+    m_passes.clear();
+    m_order.clear();
+    m_aliasedTargets.clear();
+    m_peakBytes = 0;
+}
+
+FrameGraphResource FrameGraph::importTarget(const char* name, const RenderTarget& target)
+{
+    Resource resource;
+    resource.name = name;
+    resource.desc = { target.width, target.height, target.format, target.depth != 0 };
+    resource.imported = true;
+    resource.importedTarget = target;
+    m_resources.push_back(resource);
+    return static_cast<FrameGraphResource>(m_resources.size() - 1);
+}
+
+void FrameGraph::markOutput(FrameGraphResource resource)
+{
+    m_resources[resource].output = true;
+}
+
+FrameGraph::Builder FrameGraph::addPass(const char* name)
+{
+    Pass pass;
+    pass.name = name;
+    m_passes.push_back(std::move(pass));
+    return Builder(*this, static_cast<int>(m_passes.size() - 1));
+}
+
+bool FrameGraph::uses(const Pass& pass, FrameGraphResource resource) const
+{
+    return std::find(pass.reads.begin(), pass.reads.end(), resource) != pass.reads.end()
+        || std::find(pass.writes.begin(), pass.writes.end(), resource) != pass.writes.end();
+}
+
+void FrameGraph::cullPasses()
+{
+    // Walk back from the outputs: a pass survives if something that survives reads what it writes.
+    std::vector<int> pending;
+    for (Pass& pass : m_passes) pass.culled = true;
+    for (const Resource& resource : m_resources) {
+        if (resource.output) pending.insert(pending.end(), resource.writers.begin(), resource.writers.end());
+    }
+    while (!pending.empty()) {
+        Pass& pass = m_passes[pending.back()];
+        pending.pop_back();
+        if (!pass.culled) continue;
+        pass.culled = false;
+        for (FrameGraphResource read : pass.reads) {
+            const std::vector<int>& writers = m_resources[read].writers;
+            pending.insert(pending.end(), writers.begin(), writers.end());
+        }
+    }
+}
+
+bool FrameGraph::orderPasses()
+{
+    const size_t count = m_passes.size();
+    std::vector<std::vector<int>> successors(count);
+    std::vector<int> incoming(count, 0);
+    auto addEdge = [&](int from, int to) {
+        if (from == to || m_passes[from].culled || m_passes[to].culled) return;
+        successors[from].push_back(to);
+        incoming[to]++;
+    };
+
+    for (size_t r = 0; r < m_resources.size(); ++r) {
+        const Resource& resource = m_resources[r];
+        for (size_t w = 1; w < resource.writers.size(); ++w)
+            addEdge(resource.writers[w - 1], resource.writers[w]);
+        // A pass that reads and writes the same resource is ordered by the writer chain instead.
+        for (int reader : resource.readers) {
+            if (std::find(resource.writers.begin(), resource.writers.end(), reader) != resource.writers.end()) continue;
+            for (int writer : resource.writers) addEdge(writer, reader);
+        }
+    }
+
+    // Kahn's algorithm, always taking the earliest declared ready pass so unrelated passes keep their order.
+    size_t liveCount = 0;
+    for (const Pass& pass : m_passes) liveCount += pass.culled ? 0 : 1;
+    std::vector<bool> placed(count, false);
+    m_order.clear();
+    while (m_order.size() < liveCount) {
+        int next = -1;
+        for (size_t i = 0; i < count; ++i) {
+            if (!m_passes[i].culled && !placed[i] && incoming[i] == 0) {
+                next = static_cast<int>(i);
+                break;
+            }
+        }
+        if (next < 0) break;
+        placed[next] = true;
+        m_order.push_back(next);
+        for (int successor : successors[next]) incoming[successor]--;
+    }
+
+    if (m_order.size() == liveCount) return true;
+    std::cerr << "Frame graph has a dependency cycle; running passes in declaration order\n";
+    m_order.clear();
+    for (size_t i = 0; i < count; ++i) {
+        if (!m_passes[i].culled) m_order.push_back(static_cast<int>(i));
+    }
+    return false;
+}
+
+void FrameGraph::assignLifetimes()
+{
+    for (Resource& resource : m_resources) {
+        resource.firstUse = resource.lastUse = resource.alias = -1;
+    }
+    for (int pos = 0; pos < static_cast<int>(m_order.size()); ++pos) {
+        const Pass& pass = m_passes[m_order[pos]];
+        for (const std::vector<FrameGraphResource>* list : { &pass.reads, &pass.writes }) {
+            for (FrameGraphResource r : *list) {
+                Resource& resource = m_resources[r];
+                if (resource.imported) continue;
+                if (resource.firstUse < 0) resource.firstUse = pos;
+                resource.lastUse = pos;
+            }
+        }
+    }
+
+    // Same first-free-match walk the pool does at execute time, so the totals describe what it will hold.
+    std::vector<bool> busy;
+    m_aliasedTargets.clear();
+    m_peakBytes = 0;
+    for (int pos = 0; pos < static_cast<int>(m_order.size()); ++pos) {
+        size_t liveBytes = 0;
+        for (Resource& resource : m_resources) {
+            if (resource.imported || resource.firstUse < 0 || pos < resource.firstUse || pos > resource.lastUse) continue;
+            const RenderTargetDesc& d = resource.desc;
+            liveBytes += RenderTargetPool::targetBytes(d.width, d.height, d.format, d.depth);
+            if (resource.firstUse != pos) continue;
+            for (size_t t = 0; t < m_aliasedTargets.size() && resource.alias < 0; ++t) {
+                const RenderTargetDesc& a = m_aliasedTargets[t];
+                if (!busy[t] && a.width == d.width && a.height == d.height && a.format == d.format && a.depth == d.depth)
+                    resource.alias = static_cast<int>(t);
+            }
+            if (resource.alias < 0) {
+                resource.alias = static_cast<int>(m_aliasedTargets.size());
+                m_aliasedTargets.push_back(d);
+                busy.push_back(false);
+            }
+            busy[resource.alias] = true;
+        }
+        m_peakBytes = std::max(m_peakBytes, liveBytes);
+        for (Resource& resource : m_resources) {
+            if (!resource.imported && resource.lastUse == pos) busy[resource.alias] = false;
+        }
+    }
+}
+
+bool FrameGraph::compile()
+{
+    cullPasses();
+    bool ok = orderPasses();
+    assignLifetimes();
+    return ok;
+}
+
+void FrameGraph::execute(RenderTargetPool& pool)
+{
+    for (Resource& resource : m_resources) {
+        resource.target = resource.imported ? &resource.importedTarget : nullptr;
+    }
+
+    for (int pos = 0; pos < static_cast<int>(m_order.size()); ++pos) {
+        Pass& pass = m_passes[m_order[pos]];
+        for (Resource& resource : m_resources) {
+            if (resource.imported || resource.firstUse != pos) continue;
+            const RenderTargetDesc& d = resource.desc;
+            resource.target = pool.acquire(d.width, d.height, d.format, d.depth);
+        }
+
+        // The pool already reported a target it could not create; skip the passes that need it.
+        bool ready = true;
+        for (size_t r = 0; r < m_resources.size(); ++r) {
+            if (!m_resources[r].target && uses(pass, static_cast<FrameGraphResource>(r))) ready = false;
+        }
+        if (ready && pass.execute) pass.execute();
+
+        for (Resource& resource : m_resources) {
+            if (resource.imported || resource.lastUse != pos) continue;
+            if (resource.target) pool.release(resource.target);
+            resource.target = nullptr;
+        }
+    }
+}
+
+const RenderTarget& FrameGraph::target(FrameGraphResource resource) const
+{
+    return *m_resources[resource].target;
+}
+
+size_t FrameGraph::transientCount() const
+{
+    return std::count_if(m_resources.begin(), m_resources.end(), [](const Resource& r) { return !r.imported; });
+}
+
+size_t FrameGraph::aliasedTransientBytes() const
+{
+    size_t bytes = 0;
+    for (const RenderTargetDesc& d : m_aliasedTargets)
+        bytes += RenderTargetPool::targetBytes(d.width, d.height, d.format, d.depth);
+    return bytes;
+}
+
+size_t FrameGraph::unaliasedTransientBytes() const
+{
+    size_t bytes = 0;
+    for (const Resource& r : m_resources) {
+        if (!r.imported && r.firstUse >= 0)
+            bytes += RenderTargetPool::targetBytes(r.desc.width, r.desc.height, r.desc.format, r.desc.depth);
+    }
+    return bytes;
+}
+
+std::string FrameGraph::dump() const
+{
+    std::ostringstream out;
+    char line[256];
+    auto names = [this](const std::vector<FrameGraphResource>& list, const std::vector<FrameGraphResource>* skip) {
+        std::string text;
+        for (FrameGraphResource r : list) {
+            if (skip && std::find(skip->begin(), skip->end(), r) != skip->end()) continue;
+            if (!text.empty()) text += ", ";
+            text += m_resources[r].name;
+        }
+        return text;
+    };
+
+    out << "Frame graph: " << passCount() << " passes (" << culledPassCount() << " culled), "
+        << transientCount() << " transients on " << aliasedTargetCount() << " targets\n";
+    for (size_t pos = 0; pos < m_order.size(); ++pos) {
+        const Pass& pass = m_passes[m_order[pos]];
+        std::snprintf(line, sizeof(line), "  %2zu. %-16s", pos + 1, pass.name);
+        out << line;
+        std::string created = names(pass.creates, nullptr);
+        std::string read = names(pass.reads, nullptr);
+        std::string written = names(pass.writes, &pass.creates);
+        if (!created.empty()) out << " creates [" << created << "]";
+        if (!read.empty()) out << " reads [" << read << "]";
+        if (!written.empty()) out << " writes [" << written << "]";
+        out << "\n";
+    }
+    for (const Pass& pass : m_passes) {
+        if (pass.culled) out << "  culled: " << pass.name << " (nothing live reads its output)\n";
+    }
+
+    out << "Resources (lifetime in pass numbers):\n";
+    for (const Resource& r : m_resources) {
+        const RenderTargetDesc& d = r.desc;
+        std::snprintf(line, sizeof(line), "  %-16s %5dx%-5d %s%s", r.name, d.width, d.height,
+            formatName(d.format), d.depth ? "+depth" : "");
+        out << line;
+        if (r.imported)
+            out << "  imported" << (r.output ? ", output" : "");
+        else if (r.firstUse < 0)
+            out << "  unused";
+        else {
+            std::snprintf(line, sizeof(line), "  passes %d-%d, target #%d, %.2f MB", r.firstUse + 1, r.lastUse + 1, r.alias,
+                megabytes(RenderTargetPool::targetBytes(d.width, d.height, d.format, d.depth)));
+            out << line;
+        }
+        out << "\n";
+    }
+
+    std::snprintf(line, sizeof(line), "Transient memory: peak %.2f MB live, %.2f MB in aliased targets, %.2f MB without aliasing\n",
+        megabytes(m_peakBytes), megabytes(aliasedTransientBytes()), megabytes(unaliasedTransientBytes()));
+    out << line;
+    return out.str();
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+#include "RenderTargetPool.h"
+
+// Index of a resource declared in the current frame's FrameGraph.
+using FrameGraphResource = int;
+
+struct RenderTargetDesc
+{
+    int width = 0;
+    int height = 0;
+    GLenum format = GL_RGBA8;
+    bool depth = false;
+};
+
+// Per-frame graph of render passes. Each pass declares which targets it creates, reads and
+// writes, then hands over the callback that records its GL work; compile() then
+//  - culls passes whose results never reach an output (markOutput) target,
+//  - orders the rest so every reader runs after all writers of what it reads (writers of
+//    one resource keep their declaration order),
+//  - works out each transient target's lifetime, so execute() acquires it from the
+//    RenderTargetPool right before its first pass and releases it right after its last.
+// A released target is handed to the next transient with the same size and format, so
+// transients whose lifetimes do not overlap share one set of GL objects.
+//
+// Usage per frame: reset(), importTarget()/markOutput(), addPass()..., compile(), execute().
+// Pass callbacks run inside execute(), so they may capture the frame's locals by reference.
+class FrameGraph
+{
+public:
+    static constexpr FrameGraphResource kNoResource = -1;
+
+    using Execute = std::function<void()>;
+
+    class Builder
+    {
+    public:
+        // A new transient target, written by this pass. Its contents start undefined.
+        FrameGraphResource create(const char* name, const RenderTargetDesc& desc);
+        FrameGraphResource read(FrameGraphResource resource);
+        FrameGraphResource write(FrameGraphResource resource);
+        // Runs from execute() if the pass survives culling.
+        void setExecute(Execute execute);
+
+    private:
+        friend class FrameGraph;
+        Builder(FrameGraph& graph, int pass) : m_graph(graph), m_pass(pass) {}
+        FrameGraph& m_graph;
+        int m_pass;
+    };
+
+    void reset();
+
+    // A target owned outside the graph (the window, the shadow map); never allocated or aliased.
+    FrameGraphResource importTarget(const char* name, const RenderTarget& target);
+    // Passes writing `resource` (and everything they depend on) are never culled.
+    void markOutput(FrameGraphResource resource);
+
+    // Names must outlive the frame (string literals).
+    Builder addPass(const char* name);
+
+    // False on a dependency cycle; the passes then run in declaration order.
+    bool compile();
+    void execute(RenderTargetPool& pool);
+
+    // The GL target behind `resource`; only valid inside the execute callback of a pass that declared it.
+    const RenderTarget& target(FrameGraphResource resource) const;
+
+    // Human-readable listing of the last compiled graph: pass order, culled passes,
+    // transient lifetimes and the targets they were aliased onto.
+    std::string dump() const;
+
+    size_t passCount() const { return m_passes.size(); }
+    size_t culledPassCount() const { return m_passes.size() - m_order.size(); }
+    size_t transientCount() const;
+    size_t aliasedTargetCount() const { return m_aliasedTargets.size(); }
+    // Largest total size of transients alive at the same time, the memory the aliased
+    // targets actually need, and what giving every transient its own target would take.
+    size_t peakTransientBytes() const { return m_peakBytes; }
+    size_t aliasedTransientBytes() const;
+    size_t unaliasedTransientBytes() const;
+
+private:
+    struct Resource {
+        const char* name = nullptr;
+        RenderTargetDesc desc;
+        bool imported = false;
+        bool output = false;
+        RenderTarget importedTarget;
+        RenderTarget* target = nullptr;     // set while the resource is alive during execute()
+        std::vector<int> writers;           // pass indices, declaration order
+        std::vector<int> readers;
+        int firstUse = -1;                  // positions in m_order, transients only
+        int lastUse = -1;
+        int alias = -1;                     // index into m_aliasedTargets
+    };
+
+    struct Pass {
+        const char* name = nullptr;
+        Execute execute;
+        std::vector<FrameGraphResource> creates;
+        std::vector<FrameGraphResource> reads;
+        std::vector<FrameGraphResource> writes;
+        bool culled = false;
+    };
+
+    void cullPasses();
+    bool orderPasses();
+    void assignLifetimes();
+    bool uses(const Pass& pass, FrameGraphResource resource) const;
+
+    std::vector<Resource> m_resources;
+    std::vector<Pass> m_passes;
+    std::vector<int> m_order;                       // surviving passes, execution order
+    std::vector<RenderTargetDesc> m_aliasedTargets; // one per target the transients share
+    size_t m_peakBytes = 0;
+};
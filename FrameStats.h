@@ -0,0 +1,27 @@
+#pragma once
+
+// Per-frame counters for the GL work issued through the engine wrappers
+// (ShaderProgram, Mesh, Texture). main() resets them at the top of each frame.
+struct FrameStats
+{
+    unsigned int glCalls = 0;
+    unsigned int uniformLookups = 0;   // by-name uniform location queries
+    unsigned int uniformUploads = 0;
+    unsigned int drawCalls = 0;
+    unsigned long long triangles = 0;  // submitted by those draws, instances included
+
+    // RenderQueue: items submitted vs. state changes actually issued
+    unsigned int queuedItems = 0;
+    unsigned int programBinds = 0;
+    unsigned int textureBinds = 0;
+    unsigned int vaoBinds = 0;
+
+    // Frustum culling (objects or instances tested against the camera)
+    unsigned int visibleObjects = 0;
+    unsigned int culledObjects = 0;
+    unsigned int occludedObjects = 0;  // of the culled ones, hidden behind an occluder
+
+    void reset() { *this = FrameStats(); }
+};
+
+inline FrameStats frameStats;
@@ -0,0 +1,143 @@
+#include "FrustumCuller.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define S3D_CULL_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define S3D_CULL_SSE 1
+#endif
+
+Frustum Frustum::FromMatrix(const glm::mat4& m)
+{
+    // Gribb/Hartmann: each plane is the sum or difference of the w row and an x/y/z row.
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; ++i)
+        rows[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+
+    Frustum f;
+    f.planes[0] = rows[3] + rows[0];    // left
+    f.planes[1] = rows[3] - rows[0];    // right
+    f.planes[2] = rows[3] + rows[1];    // bottom
+    f.planes[3] = rows[3] - rows[1];    // top
+    f.planes[4] = rows[3] + rows[2];    // near
+    f.planes[5] = rows[3] - rows[2];    // far
+    for (glm::vec4& p : f.planes) {
+        float len = glm::length(glm::vec3(p));
+        if (len > 0.0f) p = p / len;
+    }
+    return f;
+}
+
+void TransformSphere(const glm::mat4& m, const glm::vec3& center, float radius, glm::vec3& outCenter, float& outRadius)
+{
+    outCenter = glm::vec3(m * glm::vec4(center, 1.0f));
+    float sx = glm::length(glm::vec3(m[0]));
+    float sy = glm::length(glm::vec3(m[1]));
+    float sz = glm::length(glm::vec3(m[2]));
+    outRadius = radius * std::max(sx, std::max(sy, sz));
+}
+
+void FrustumCuller::clear()
+{
+    m_x.clear();
+    m_y.clear();
+    m_z.clear();
+    m_r.clear();
+}
+
+void FrustumCuller::reserve(size_t count)
+{
+    m_x.reserve(count);
+    m_y.reserve(count);
+    m_z.reserve(count);
+    m_r.reserve(count);
+}
+
+void FrustumCuller::add(const glm::vec3& center, float radius)
+{
+    m_x.push_back(center.x);
+    m_y.push_back(center.y);
+    m_z.push_back(center.z);
+    m_r.push_back(radius);
+}
+
+size_t FrustumCuller::cull(const Frustum& frustum, uint8_t* mask, uint8_t bit) const
+{
+    const size_t n = m_x.size();
+    size_t visible = 0;
+    size_t i = 0;
+
+#if defined(S3D_CULL_AVX)
+    __m256 px[6], py[6], pz[6], pw[6];
+    for (int p = 0; p < 6; ++p) {
+        px[p] = _mm256_set1_ps(frustum.planes[p].x);
+        py[p] = _mm256_set1_ps(frustum.planes[p].y);
+        pz[p] = _mm256_set1_ps(frustum.planes[p].z);
+        pw[p] = _mm256_set1_ps(frustum.planes[p].w);
+    }
+    const __m256 zero = _mm256_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+        __m256 x = _mm256_loadu_ps(&m_x[i]);
+        __m256 y = _mm256_loadu_ps(&m_y[i]);
+        __m256 z = _mm256_loadu_ps(&m_z[i]);
+        __m256 negR = _mm256_sub_ps(zero, _mm256_loadu_ps(&m_r[i]));
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p) {
+            __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px[p], x), _mm256_mul_ps(py[p], y)),
+                _mm256_add_ps(_mm256_mul_ps(pz[p], z), pw[p]));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, negR, _CMP_GE_OQ));
+        }
+        int bits = _mm256_movemask_ps(inside);
+        for (int k = 0; k < 8; ++k) {
+            if (bits & (1 << k)) {
+                mask[i + k] |= bit;
+                visible++;
+            }
+        }
+    }
+#elif defined(S3D_CULL_SSE)
+    __m128 px[6], py[6], pz[6], pw[6];
+    for (int p = 0; p < 6; ++p) {
+        px[p] = _mm_set1_ps(frustum.planes[p].x);
+        py[p] = _mm_set1_ps(frustum.planes[p].y);
+        pz[p] = _mm_set1_ps(frustum.planes[p].z);
+        pw[p] = _mm_set1_ps(frustum.planes[p].w);
+    }
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4) {
+        __m128 x = _mm_loadu_ps(&m_x[i]);
+        __m128 y = _mm_loadu_ps(&m_y[i]);
+        __m128 z = _mm_loadu_ps(&m_z[i]);
+        __m128 negR = _mm_sub_ps(zero, _mm_loadu_ps(&m_r[i]));
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p) {
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px[p], x), _mm_mul_ps(py[p], y)),
+                _mm_add_ps(_mm_mul_ps(pz[p], z), pw[p]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negR));
+        }
+        int bits = _mm_movemask_ps(inside);
+        for (int k = 0; k < 4; ++k) {
+            if (bits & (1 << k)) {
+                mask[i + k] |= bit;
+                visible++;
+            }
+        }
+    }
+#endif
+
+    for (; i < n; ++i) {
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; ++p) {
+            const glm::vec4& pl = frustum.planes[p];
+            inside = pl.x * m_x[i] + pl.y * m_y[i] + pl.z * m_z[i] + pl.w >= -m_r[i];
+        }
+        if (inside) {
+            mask[i] |= bit;
+            visible++;
+        }
+    }
+    return visible;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+struct Frustum {
+    glm::vec4 planes[6];    // xyz = inward normal, w = distance; normalized
+
+    // Extracts the planes of a (model-)view-projection matrix. Passing projection * view * model
+    // yields planes in the model's space, so bounds stored there can be tested without transforming them.
+    static Frustum FromMatrix(const glm::mat4& m);
+};
+
+// Transforms an object-space bounding sphere by `m`, growing the radius by the largest axis scale.
+void TransformSphere(const glm::mat4& m, const glm::vec3& center, float radius, glm::vec3& outCenter, float& outRadius);
+
+// Bounding spheres kept in structure-of-arrays form and tested against a frustum
+// 8 (AVX) or 4 (SSE) at a time, with a scalar path for the remainder.
+class FrustumCuller
+{
+public:
+    void clear();
+    void reserve(size_t count);
+    void add(const glm::vec3& center, float radius);
+    size_t size() const { return m_x.size(); }
+
+    // Sets `bit` in mask[i] for every sphere intersecting the frustum and returns how many did.
+    // `mask` must hold size() entries.
+    size_t cull(const Frustum& frustum, uint8_t* mask, uint8_t bit) const;
+
+private:
+    std::vector<float> m_x, m_y, m_z, m_r;
+};
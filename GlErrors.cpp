@@ -0,0 +1,17 @@
+#include "GlErrors.h"
+#include <GL/glew.h>
+#include <iostream>
+
+// More than any driver keeps: GL records at most one flag per error kind.
+static const int kMaxPendingErrors = 16;
+
+int ClearGlErrors(const char* context)
+{
+    int cleared = 0;
+    for (; cleared < kMaxPendingErrors; ++cleared) {
+        GLenum error = glGetError();
+        if (error == GL_NO_ERROR) break;
+        std::cerr << "GL error 0x" << std::hex << error << std::dec << " was pending before " << context << "\n";
+    }
+    return cleared;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+// Discards the errors already pending, so a following glGetError() check only sees what the
+// calls after it raised. Each discarded error is reported with `context` (whose check it
+// would have failed) rather than dropped silently. Stops after a fixed number of reads,
+// since a lost context can keep reporting an error forever. Returns how many were discarded.
+int ClearGlErrors(const char* context);
@@ -0,0 +1,60 @@
+#include "GpuTimer.h"
+
+GpuTimer::~GpuTimer()
+{
+    if (m_queries[0][0]) glDeleteQueries(kLatency * 2, &m_queries[0][0]);
+}
+
+bool GpuTimer::init()
+{
+    glGenQueries(kLatency * 2, &m_queries[0][0]);
+    return m_queries[0][0] != 0;
+}
+
+void GpuTimer::collect(bool wait)
+{
+    while (m_pending > 0) {
+        const GLuint* pair = m_queries[(m_next - m_pending + kLatency) % kLatency];
+        if (!wait) {
+            GLint available = 0;
+            glGetQueryObjectiv(pair[1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) return;
+        }
+        GLuint64 start = 0, stop = 0;
+        glGetQueryObjectui64v(pair[0], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(pair[1], GL_QUERY_RESULT, &stop);
+        m_ms = (stop - start) / 1.0e6;
+        m_hasResult = true;
+        m_pending--;
+        // Only the oldest pair may block; the rest are picked up on later frames.
+        wait = false;
+    }
+}
+
+void GpuTimer::begin()
+{
+    if (!m_queries[0][0] || m_active) return;
+    collect(false);
+    // Every slot still in flight: the GPU is over kLatency frames behind, so wait for the oldest.
+    if (m_pending == kLatency) collect(true);
+
+    glQueryCounter(m_queries[m_next][0], GL_TIMESTAMP);
+    m_active = true;
+}
+
+void GpuTimer::end()
+{
+    if (!m_active) return;
+    glQueryCounter(m_queries[m_next][1], GL_TIMESTAMP);
+    m_next = (m_next + 1) % kLatency;
+    m_pending++;
+    m_active = false;
+}
+
+bool GpuTimer::takeResult(double& ms)
+{
+    if (!m_hasResult) return false;
+    ms = m_ms;
+    m_hasResult = false;
+    return true;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <GL/glew.h>
+
+// Measures GPU time between begin() and end() with a pair of GL_TIMESTAMP queries, so it
+// can span profiler scopes (GL_TIME_ELAPSED queries cannot nest). Results are read back
+// kLatency frames late at most, so the CPU does not wait on the GPU to finish the frame.
+class GpuTimer
+{
+public:
+    GpuTimer() = default;
+    ~GpuTimer();
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    bool init();
+
+    void begin();
+    void end();
+
+    // Newest result that came back since the last call; false if there is none.
+    bool takeResult(double& ms);
+
+private:
+    static const int kLatency = 4;
+
+    void collect(bool wait);
+
+    GLuint m_queries[kLatency][2] = {};
+    int m_next = 0;         // slot the next begin() writes
+    int m_pending = 0;      // issued pairs not read back yet, oldest at m_next - m_pending
+    bool m_active = false;
+    bool m_hasResult = false;
+    double m_ms = 0.0;
+};
@@ -0,0 +1,416 @@
+#include "Headless.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "FrameStats.h"
+#include "FrameCapture.h"
+#include "HeadlessContext.h"
+#include "ImageWriter.h"
+#include "JobSystem.h"
+#include "MeshPool.h"
+#include "Profiler.h"
+#include "Renderer.h"
+#include "Simulation.h"
+
+static void printUsage()
+{
+    std::cerr << "Usage: Simple3DProject --headless [--frames N] [--size WxH] [--scene default|instanced|dense|objects]\n"
+                 "       [--instances N] [--shape triangle|rectangle|circle|pyramid|sphere] [--3d] [--animate] [--lights N]\n"
+                 "       [--prepass] [--overdraw] [--no-occlusion] [--post off|EFFECT,...] [--out DIR] [--png-every N] [--record png|y4m] [--trace FILE]\n"
+                 "       [--dynamic-res] [--dump-graph] [--thread-sweep N]\n"
+                 "       [--sim-rate N] [--time-scale X] [--no-lod] [--lod-error PIXELS]\n";
+}
+
+bool ParseHeadlessArgs(int argc, char** argv, HeadlessOptions& options, SceneSettings& scene)
+{
+    // Fixed-size frames keep runs comparable; --dynamic-res opts in.
+    scene.dynamicResolution = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        auto needsValue = [&]() {
+            if (value) { ++i; return true; }
+            std::cerr << "Missing value for " << arg << "\n";
+            return false;
+        };
+
+        if (arg == "--headless") {
+            continue;
+        }
+        else if (arg == "--frames") {
+            if (!needsValue()) return false;
+            options.frames = std::max(1, std::atoi(value));
+        }
+        else if (arg == "--size") {
+            if (!needsValue()) return false;
+            if (std::sscanf(value, "%dx%d", &options.width, &options.height) != 2 || options.width <= 0 || options.height <= 0) {
+                std::cerr << "Bad --size value: " << value << "\n";
+                return false;
+            }
+        }
+        else if (arg == "--scene") {
+            if (!needsValue()) return false;
+            if (std::strcmp(value, "instanced") == 0) scene.instancedScene = true;
+            else if (std::strcmp(value, "default") == 0) scene.instancedScene = false;
+            else if (std::strcmp(value, "dense") == 0) {
+                // Vertex-bound benchmark: instanced high-tessellation spheres.
+                scene.instancedScene = true;
+                scene.shape = SPHERE;
+            }
+            else if (std::strcmp(value, "objects") == 0) {
+                // CPU submission benchmark: every object is its own draw packet.
+                scene.instancedScene = true;
+                scene.separateDraws = true;
+                scene.instanceCount = 10000;
+            }
+            else {
+                std::cerr << "Unknown scene: " << value << "\n";
+                return false;
+            }
+        }
+        else if (arg == "--instances") {
+            if (!needsValue()) return false;
+            scene.instanceCount = std::max(1, std::atoi(value));
+        }
+        else if (arg == "--shape") {
+            if (!needsValue()) return false;
+            if (std::strcmp(value, "triangle") == 0) scene.shape = TRIANGLE;
+            else if (std::strcmp(value, "rectangle") == 0) scene.shape = RECTANGLE;
+            else if (std::strcmp(value, "circle") == 0) scene.shape = CIRCLE;
+            else if (std::strcmp(value, "pyramid") == 0) scene.shape = PYRAMID;
+            else if (std::strcmp(value, "sphere") == 0) scene.shape = SPHERE;
+            else {
+                std::cerr << "Unknown shape: " << value << "\n";
+                return false;
+            }
+        }
+        else if (arg == "--lights") {
+            if (!needsValue()) return false;
+            scene.pointLights = true;
+            scene.pointLightCount = std::clamp(std::atoi(value), 1, ClusteredLights::kMaxLights);
+        }
+        else if (arg == "--prepass") {
+            scene.depthPrepass = true;
+        }
+        else if (arg == "--overdraw") {
+            scene.overdrawView = true;
+        }
+        else if (arg == "--no-occlusion") {
+            scene.occlusionCulling = false;
+        }
+        else if (arg == "--post") {
+            // "off", or the effects to enable from tonemap, fxaa and bloom.
+            if (!needsValue()) return false;
+            std::string effects = std::string(",") + value + ",";
+            scene.postProcess = effects != ",off,";
+            scene.tonemap = effects.find(",tonemap,") != std::string::npos;
+            scene.fxaa = effects.find(",fxaa,") != std::string::npos;
+            scene.bloom = effects.find(",bloom,") != std::string::npos;
+        }
+        else if (arg == "--3d") {
+            scene.is3DMode = true;
+        }
+        else if (arg == "--animate") {
+            scene.toggleSpin = true;
+            scene.toggleUpDown = true;
+            scene.animateLight = true;
+        }
+        else if (arg == "--out") {
+            if (!needsValue()) return false;
+            options.outDir = value;
+        }
+        else if (arg == "--png-every") {
+            if (!needsValue()) return false;
+            options.pngEvery = std::max(0, std::atoi(value));
+        }
+        else if (arg == "--record") {
+            if (!needsValue()) return false;
+            if (std::strcmp(value, "png") != 0 && std::strcmp(value, "y4m") != 0) {
+                std::cerr << "Unknown --record format: " << value << "\n";
+                return false;
+            }
+            options.record = value;
+        }
+        else if (arg == "--trace") {
+            if (!needsValue()) return false;
+            options.tracePath = value;
+        }
+        else if (arg == "--dynamic-res") {
+            scene.dynamicResolution = true;
+        }
+        else if (arg == "--dump-graph") {
+            options.dumpGraph = true;
+        }
+        else if (arg == "--sim-rate") {
+            if (!needsValue()) return false;
+            options.simRate = std::max(1, std::atoi(value));
+        }
+        else if (arg == "--time-scale") {
+            if (!needsValue()) return false;
+            options.timeScale = std::max(0.0f, static_cast<float>(std::atof(value)));
+        }
+        else if (arg == "--no-lod") {
+            scene.meshLod = false;
+        }
+        else if (arg == "--lod-error") {
+            if (!needsValue()) return false;
+            scene.lodPixelError = std::max(0.01f, static_cast<float>(std::atof(value)));
+        }
+        else if (arg == "--thread-sweep") {
+            if (!needsValue()) return false;
+            options.threadSweep = std::max(1, std::atoi(value));
+        }
+        else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            printUsage();
+            return false;
+        }
+    }
+    if (options.threadSweep > 0 && !(scene.instancedScene && scene.separateDraws)) {
+        std::cerr << "--thread-sweep measures draw packet recording; use it with --scene objects\n";
+        return false;
+    }
+    return true;
+}
+
+static double percentile(const std::vector<double>& sorted, double p)
+{
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+int RunHeadless(const Config& config, SceneSettings scene, const HeadlessOptions& options)
+{
+    HeadlessContext context;
+    if (!context.create()) return -1;
+
+    // GLEW built for GLX reports a missing X display after it has already loaded the
+    // core entry points, which is all the renderer needs.
+    glewExperimental = GL_TRUE;
+    GLenum glewStatus = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    if (glewStatus == GLEW_ERROR_NO_GLX_DISPLAY) glewStatus = GLEW_OK;
+#endif
+    if (glewStatus != GLEW_OK) {
+        std::cerr << "Failed to initialize GLEW: " << glewGetErrorString(glewStatus) << "\n";
+        return -1;
+    }
+    std::cout << "Headless renderer: " << glGetString(GL_RENDERER) << " (" << glGetString(GL_VERSION) << ")\n";
+
+    std::error_code ec;
+    std::filesystem::create_directories(options.outDir, ec);
+    if (ec) {
+        std::cerr << "Could not create output directory " << options.outDir << ": " << ec.message() << "\n";
+        return -1;
+    }
+
+    // Offscreen target standing in for the window's default framebuffer.
+    GLuint fbo = 0, colorRb = 0, depthRb = 0;
+    glGenFramebuffers(1, &fbo);
+    glGenRenderbuffers(1, &colorRb);
+    glGenRenderbuffers(1, &depthRb);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorRb);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, options.width, options.height);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthRb);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, options.width, options.height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRb);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRb);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Headless framebuffer incomplete\n";
+        return -1;
+    }
+
+    profiler.init();
+    jobSystem.init(config.getInt("job_threads", 0));
+
+    int exitCode = 0;
+    {
+        Renderer renderer;
+        if (!renderer.init(config)) {
+            // Frames from a partly initialized renderer would be written out as real results.
+            std::cerr << "Renderer failed to initialize; no frames rendered\n";
+            jobSystem.shutdown();
+            profiler.shutdown();
+            return -1;
+        }
+        if (!renderer.shadowMapReady()) scene.shadowsEnabled = false;
+        if (scene.useTexture && !renderer.loadTexture()) scene.useTexture = false;
+
+        std::vector<double> frameMs(options.frames);
+        std::vector<FrameStats> stats(options.frames);
+        double shadedFragments = 0.0;
+        double renderedPixels = 0.0;
+        double scaleSum = 0.0;
+        double occlusionMs = 0.0;
+        int occlusionFrames = 0;
+        double packetRecordMs = 0.0;
+        double packetMergeMs = 0.0;
+        double packetCount = 0.0;
+        std::vector<unsigned char> pixels;
+
+        FrameCapture capture;
+        if (!options.record.empty()) {
+            capture.init(options.outDir, config.getInt("capture_fps", 60));
+            if (options.record == "y4m") capture.startVideo();
+            else capture.startPngSequence();
+        }
+        using Clock = std::chrono::steady_clock;
+
+        Simulation simulation;
+        simulation.setRate(options.simRate > 0 ? options.simRate : config.getInt("sim_rate", 120));
+        simulation.setTimeScale(options.timeScale);
+        simulation.setInputs(scene);
+
+        for (int frame = 0; frame < options.frames; ++frame) {
+            frameStats.reset();
+            profiler.beginFrame();
+            // Fixed 60 Hz frame delta so every run simulates the same steps and renders the same images.
+            const SimState state = simulation.advance(frame == 0 ? 0.0 : 1.0 / 60.0);
+
+            Clock::time_point start = Clock::now();
+            renderer.renderFrame(scene, state, options.width, options.height, fbo);
+            capture.captureFrame(fbo, options.width, options.height);
+            glFinish();
+            frameMs[frame] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            stats[frame] = frameStats;
+            // The frame was just finished, so this is the count of the previous one at worst.
+            shadedFragments += static_cast<double>(renderer.shadedFragments());
+            renderedPixels += static_cast<double>(renderer.renderWidth()) * renderer.renderHeight();
+            scaleSum += renderer.dynamicResolution().scale();
+            if (renderer.occlusionRan()) {
+                occlusionMs += renderer.occlusionCuller().rasterMs() + renderer.occlusionCuller().testMs();
+                occlusionFrames++;
+            }
+            if (scene.separateDraws) {
+                const DrawPacketStats& packets = renderer.drawPacketStats();
+                packetRecordMs += packets.recordMs;
+                packetMergeMs += packets.mergeMs;
+                packetCount += static_cast<double>(packets.packets);
+            }
+
+            if (options.pngEvery > 0 && frame % options.pngEvery == 0) {
+                pixels.resize(static_cast<size_t>(options.width) * options.height * 4);
+                glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+                glPixelStorei(GL_PACK_ALIGNMENT, 1);
+                glReadPixels(0, 0, options.width, options.height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+                char name[32];
+                std::snprintf(name, sizeof(name), "frame_%05d.png", frame);
+                WritePNG((std::filesystem::path(options.outDir) / name).string(),
+                    options.width, options.height, 4, pixels.data(), true);
+            }
+        }
+        if (!options.record.empty()) {
+            capture.shutdown();
+            std::printf("Capture: %u frames written, %u dropped, %.3f ms avg render-thread cost\n",
+                capture.framesWritten(), capture.framesDropped(), capture.averageCostMs());
+        }
+
+        std::string csvPath = (std::filesystem::path(options.outDir) / "frame_times.csv").string();
+        std::ofstream csv(csvPath);
+        if (!csv) {
+            std::cerr << "Could not write " << csvPath << "\n";
+            exitCode = -1;
+        }
+        else {
+            csv << "frame,ms,draw_calls,gl_calls,visible,culled,occluded,triangles\n";
+            for (int frame = 0; frame < options.frames; ++frame) {
+                csv << frame << "," << frameMs[frame] << "," << stats[frame].drawCalls << "," << stats[frame].glCalls << ","
+                    << stats[frame].visibleObjects << "," << stats[frame].culledObjects << "," << stats[frame].occludedObjects << ","
+                    << stats[frame].triangles << "\n";
+            }
+        }
+
+        std::vector<double> sorted = frameMs;
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0.0;
+        for (double ms : sorted) total += ms;
+        std::printf("Headless: %d frames at %dx%d, avg %.3f ms, p50 %.3f ms, p95 %.3f ms, max %.3f ms\n",
+            options.frames, options.width, options.height, total / options.frames,
+            percentile(sorted, 0.50), percentile(sorted, 0.95), sorted.back());
+        if (scene.occlusionCulling && scene.is3DMode) {
+            double occluded = 0.0;
+            for (const FrameStats& s : stats) occluded += s.occludedObjects;
+            std::printf("Occlusion culling: %.1f objects occluded per frame, %.3f ms CPU per frame it ran (%d of %d)\n",
+                occluded / options.frames, occlusionFrames > 0 ? occlusionMs / occlusionFrames : 0.0, occlusionFrames, options.frames);
+        }
+        std::printf("Simulation: %llu steps at %d Hz, time scale %.2f, %llu dropped\n", simulation.steps(),
+            simulation.rate(), simulation.timeScale(), simulation.droppedSteps());
+        double triangles = 0.0;
+        for (const FrameStats& s : stats) triangles += static_cast<double>(s.triangles);
+        std::printf("Triangles: %.0f submitted per frame, all passes (mesh LOD %s)\n", triangles / options.frames,
+            scene.meshLod ? "on" : "off");
+        if (!renderer.lodCounts().empty()) {
+            std::printf("LOD levels (last frame, finest first):");
+            for (unsigned int count : renderer.lodCounts()) std::printf(" %u", count);
+            std::printf("\n");
+        }
+        std::printf("Mesh pool: %zu meshes in %.2f MB, %d/%d vertices, %d/%d indices, %zu+%zu free blocks, %u defragmentations, %u growths\n",
+            meshPool.meshCount(), meshPool.memoryBytes() / (1024.0 * 1024.0), meshPool.vertexSpace().used(),
+            meshPool.vertexSpace().capacity(), meshPool.indexSpace().used(), meshPool.indexSpace().capacity(),
+            meshPool.vertexSpace().freeBlocks(), meshPool.indexSpace().freeBlocks(), meshPool.defragmentations(), meshPool.growths());
+        std::printf("Shading pass: %.3f fragments per pixel%s\n", shadedFragments / renderedPixels,
+            scene.depthPrepass ? " (depth pre-pass)" : "");
+        if (scene.dynamicResolution) {
+            const DynamicResolution& resolution = renderer.dynamicResolution();
+            std::printf("Dynamic resolution: average scale %.2f, final %.2f (%dx%d), target %.1f ms, last GPU average %.2f ms\n",
+                scaleSum / options.frames, resolution.scale(), renderer.renderWidth(), renderer.renderHeight(),
+                resolution.targetMs(), resolution.averageMs());
+        }
+        if (scene.postProcess) {
+            const RenderTargetPool& targets = renderer.renderTargets();
+            std::printf("Render targets: %zu pooled, %.2f MB, %u created over the run\n",
+                targets.targetCount(), targets.memoryBytes() / (1024.0 * 1024.0), targets.created());
+        }
+        if (scene.instancedScene && scene.separateDraws) {
+            std::printf("Draw packets: %.0f per frame on %d threads, record %.3f ms, merge %.3f ms per frame\n",
+                packetCount / options.frames, renderer.drawPacketStats().threads,
+                packetRecordMs / options.frames, packetMergeMs / options.frames);
+        }
+        if (options.threadSweep > 0) {
+            // Same frames again per thread count; only the packet timings are of interest here.
+            double baseMs = 0.0;
+            for (int threads = 1; threads <= options.threadSweep; ++threads) {
+                if (threads == 1) jobSystem.shutdown();
+                else jobSystem.init(threads - 1);
+                double recordMs = 0.0, mergeMs = 0.0;
+                for (int frame = 0; frame < options.frames; ++frame) {
+                    frameStats.reset();
+                    profiler.beginFrame();
+                    renderer.renderFrame(scene, simulation.advance(1.0 / 60.0), options.width, options.height, fbo);
+                    glFinish();
+                    recordMs += renderer.drawPacketStats().recordMs;
+                    mergeMs += renderer.drawPacketStats().mergeMs;
+                }
+                recordMs /= options.frames;
+                mergeMs /= options.frames;
+                if (threads == 1) baseMs = recordMs;
+                std::printf("Thread sweep: %2d threads, record %.3f ms, merge %.3f ms, record speedup %.2fx\n",
+                    threads, recordMs, mergeMs, recordMs > 0.0 ? baseMs / recordMs : 0.0);
+            }
+            std::printf("Thread sweep: %u hardware threads available\n", std::thread::hardware_concurrency());
+        }
+        if (options.dumpGraph) std::printf("%s", renderer.frameGraph().dump().c_str());
+        std::printf("Frame timings written to %s\n", csvPath.c_str());
+    }
+
+    if (!options.tracePath.empty()) profiler.writeChromeTrace(options.tracePath);
+    jobSystem.shutdown();
+    profiler.shutdown();
+    meshPool.shutdown();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteRenderbuffers(1, &colorRb);
+    glDeleteRenderbuffers(1, &depthRb);
+    return exitCode;
+}
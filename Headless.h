@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+#include "Config.h"
+#include "SceneSettings.h"
+
+// Settings for a --headless run: render a fixed number of frames offscreen as fast as
+// possible and record how long each one took.
+struct HeadlessOptions
+{
+    int frames = 300;
+    int width = 1600;
+    int height = 900;
+    std::string outDir = "headless_out";
+    int pngEvery = 0;       // write every Nth frame as a PNG; 0 = none
+    std::string record;     // "png" or "y4m": capture every frame through FrameCapture
+    std::string tracePath;  // Chrome trace JSON of the run; empty = none
+    bool dumpGraph = false; // print the last frame's compiled frame graph
+    int threadSweep = 0;    // re-run with 1..N job threads and compare draw packet timings; 0 = off
+    int simRate = 0;        // simulation steps per second; 0 = sim_rate from the config
+    float timeScale = 1.0f; // simulated seconds per (fixed, 1/60 s) frame second
+};
+
+// Reads --frames N, --size WxH, --scene default|instanced|dense|objects, --instances N, --shape NAME,
+// --3d, --animate, --lights N, --prepass, --overdraw, --no-occlusion, --post off|EFFECT,...,
+// --out DIR, --png-every N, --record png|y4m, --trace FILE, --dynamic-res, --dump-graph,
+// --thread-sweep N, --sim-rate N, --time-scale X, --no-lod and --lod-error PIXELS.
+// Scene flags edit `scene` in place; dynamic resolution is off unless asked for.
+bool ParseHeadlessArgs(int argc, char** argv, HeadlessOptions& options, SceneSettings& scene);
+
+// Returns the process exit code.
+int RunHeadless(const Config& config, SceneSettings scene, const HeadlessOptions& options);
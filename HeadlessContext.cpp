@@ -0,0 +1,100 @@
+#include "HeadlessContext.h"
+#include <iostream>
+
+#ifdef SIMPLE3D_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstring>
+
+static bool hasExtension(const char* list, const char* name)
+{
+    if (!list) return false;
+    size_t len = std::strlen(name);
+    for (const char* p = std::strstr(list, name); p; p = std::strstr(p + len, name)) {
+        if ((p == list || p[-1] == ' ') && (p[len] == ' ' || p[len] == '\0')) return true;
+    }
+    return false;
+}
+
+bool HeadlessContext::create()
+{
+    EGLDisplay display = EGL_NO_DISPLAY;
+
+    // Prefer the surfaceless platform so no X or Wayland server is needed.
+    const char* clientExts = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (hasExtension(clientExts, "EGL_MESA_platform_surfaceless")) {
+        auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (getPlatformDisplay)
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+        std::cerr << "Failed to initialize EGL display\n";
+        return false;
+    }
+    m_display = display;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "EGL: desktop OpenGL API not available\n";
+        destroy();
+        return false;
+    }
+
+    // Rendering goes to an FBO, so any config (or none, with EGL_KHR_no_config_context) will do.
+    const EGLint configAttribs[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    EGLConfig config = nullptr;
+    EGLint numConfigs = 0;
+    eglChooseConfig(display, configAttribs, &config, 1, &numConfigs);
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, numConfigs > 0 ? config : nullptr, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT) {
+        std::cerr << "Failed to create EGL OpenGL 3.3 core context\n";
+        destroy();
+        return false;
+    }
+    m_context = context;
+
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        std::cerr << "Failed to make EGL context current (surfaceless contexts unsupported?)\n";
+        destroy();
+        return false;
+    }
+    return true;
+}
+
+void HeadlessContext::destroy()
+{
+    if (!m_display) return;
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (m_context) eglDestroyContext(m_display, m_context);
+    eglTerminate(m_display);
+    m_context = nullptr;
+    m_display = nullptr;
+}
+
+#else
+
+bool HeadlessContext::create()
+{
+    std::cerr << "Headless mode needs EGL; this build was configured without it\n";
+    return false;
+}
+
+void HeadlessContext::destroy()
+{
+}
+
+#endif
+
+HeadlessContext::~HeadlessContext()
+{
+    destroy();
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+// Offscreen OpenGL 3.3 core context with no window system, for running on build
+// servers (Mesa llvmpipe or any EGL driver exposing EGL_MESA_platform_surfaceless).
+// Only available when the build found EGL (SIMPLE3D_HAS_EGL); create() fails otherwise.
+class HeadlessContext
+{
+public:
+    HeadlessContext() = default;
+    ~HeadlessContext();
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+    // Creates the context and makes it current on the calling thread.
+    bool create();
+    void destroy();
+
+private:
+    void* m_display = nullptr;
+    void* m_context = nullptr;
+};
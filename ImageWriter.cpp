@@ -0,0 +1,183 @@
+#include "ImageWriter.h"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+struct CrcTable
+{
+    uint32_t entries[256];
+    CrcTable()
+    {
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[n] = c;
+        }
+    }
+};
+
+static uint32_t updateCrc(uint32_t crc, const unsigned char* data, size_t len)
+{
+    static const CrcTable table;
+    for (size_t i = 0; i < len; ++i)
+        crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+static void putU32(std::vector<unsigned char>& out, uint32_t v)
+{
+    out.push_back(static_cast<unsigned char>(v >> 24));
+    out.push_back(static_cast<unsigned char>(v >> 16));
+    out.push_back(static_cast<unsigned char>(v >> 8));
+    out.push_back(static_cast<unsigned char>(v));
+}
+
+static void writeChunk(std::ofstream& file, const char type[4], const std::vector<unsigned char>& data)
+{
+    std::vector<unsigned char> header;
+    putU32(header, static_cast<uint32_t>(data.size()));
+    header.insert(header.end(), type, type + 4);
+    uint32_t crc = updateCrc(0xFFFFFFFFu, header.data() + 4, 4);
+    crc = updateCrc(crc, data.data(), data.size()) ^ 0xFFFFFFFFu;
+    std::vector<unsigned char> trailer;
+    putU32(trailer, crc);
+
+    file.write(reinterpret_cast<const char*>(header.data()), header.size());
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    file.write(reinterpret_cast<const char*>(trailer.data()), trailer.size());
+}
+
+bool WritePNG(const std::string& path, int width, int height, int channels, const unsigned char* pixels, bool flipVertical)
+{
+    if (width <= 0 || height <= 0 || (channels != 3 && channels != 4) || !pixels) {
+        std::cerr << "WritePNG: invalid image for " << path << "\n";
+        return false;
+    }
+
+    // Raw scanlines, each prefixed with filter type 0 (None).
+    const size_t rowBytes = static_cast<size_t>(width) * channels;
+    std::vector<unsigned char> raw;
+    raw.reserve((rowBytes + 1) * height);
+    for (int y = 0; y < height; ++y) {
+        const unsigned char* row = pixels + rowBytes * (flipVertical ? height - 1 - y : y);
+        raw.push_back(0);
+        raw.insert(raw.end(), row, row + rowBytes);
+    }
+
+    // zlib stream made of stored (uncompressed) deflate blocks of at most 65535 bytes.
+    std::vector<unsigned char> idat;
+    idat.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    idat.push_back(0x78);
+    idat.push_back(0x01);
+    uint32_t a = 1, b = 0;
+    size_t pos = 0;
+    do {
+        size_t len = std::min<size_t>(raw.size() - pos, 65535);
+        bool last = pos + len == raw.size();
+        idat.push_back(last ? 1 : 0);
+        idat.push_back(static_cast<unsigned char>(len));
+        idat.push_back(static_cast<unsigned char>(len >> 8));
+        idat.push_back(static_cast<unsigned char>(~len));
+        idat.push_back(static_cast<unsigned char>(~len >> 8));
+        idat.insert(idat.end(), raw.begin() + pos, raw.begin() + pos + len);
+        for (size_t i = pos; i < pos + len; ++i) {
+            a = (a + raw[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+        pos += len;
+    } while (pos < raw.size());
+    putU32(idat, (b << 16) | a);
+
+    std::vector<unsigned char> ihdr;
+    putU32(ihdr, static_cast<uint32_t>(width));
+    putU32(ihdr, static_cast<uint32_t>(height));
+    ihdr.push_back(8);                          // bit depth
+    ihdr.push_back(channels == 4 ? 6 : 2);      // color type: RGBA or RGB
+    ihdr.push_back(0);                          // compression
+    ihdr.push_back(0);                          // filter
+    ihdr.push_back(0);                          // interlace
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "WritePNG: could not open " << path << "\n";
+        return false;
+    }
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+    writeChunk(file, "IHDR", ihdr);
+    writeChunk(file, "IDAT", idat);
+    writeChunk(file, "IEND", std::vector<unsigned char>());
+    return static_cast<bool>(file);
+}
+
+Y4MWriter::~Y4MWriter()
+{
+    close();
+}
+
+bool Y4MWriter::open(const std::string& path, int width, int height, int fps)
+{
+    close();
+    // 4:2:0 chroma needs even dimensions; the last row/column is dropped otherwise.
+    m_sourceWidth = width;
+    m_sourceHeight = height;
+    m_width = width & ~1;
+    m_height = height & ~1;
+    if (m_width <= 0 || m_height <= 0) return false;
+
+    m_file = std::fopen(path.c_str(), "wb");
+    if (!m_file) {
+        std::cerr << "Y4MWriter: could not open " << path << "\n";
+        return false;
+    }
+    std::fprintf(m_file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", m_width, m_height, fps);
+    m_planes.resize(static_cast<size_t>(m_width) * m_height * 3 / 2);
+    return true;
+}
+
+bool Y4MWriter::writeFrame(const unsigned char* rgba, bool flipVertical)
+{
+    if (!m_file) return false;
+
+    // Source rows keep the original (possibly odd) size.
+    const int w = m_width, h = m_height;
+    const size_t stride = static_cast<size_t>(m_sourceWidth) * 4;
+    auto pixel = [&](int x, int y) {
+        return rgba + (flipVertical ? m_sourceHeight - 1 - y : y) * stride + static_cast<size_t>(x) * 4;
+    };
+
+    unsigned char* yPlane = m_planes.data();
+    unsigned char* uPlane = yPlane + static_cast<size_t>(w) * h;
+    unsigned char* vPlane = uPlane + static_cast<size_t>(w / 2) * (h / 2);
+    for (int y = 0; y < h; y += 2) {
+        for (int x = 0; x < w; x += 2) {
+            int sumR = 0, sumG = 0, sumB = 0;
+            for (int dy = 0; dy < 2; ++dy) {
+                for (int dx = 0; dx < 2; ++dx) {
+                    const unsigned char* p = pixel(x + dx, y + dy);
+                    int r = p[0], g = p[1], b = p[2];
+                    yPlane[(y + dy) * w + x + dx] = static_cast<unsigned char>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+                    sumR += r;
+                    sumG += g;
+                    sumB += b;
+                }
+            }
+            int r = sumR / 4, g = sumG / 4, b = sumB / 4;
+            size_t c = static_cast<size_t>(y / 2) * (w / 2) + x / 2;
+            uPlane[c] = static_cast<unsigned char>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            vPlane[c] = static_cast<unsigned char>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+
+    std::fputs("FRAME\n", m_file);
+    return std::fwrite(m_planes.data(), 1, m_planes.size(), m_file) == m_planes.size();
+}
+
+void Y4MWriter::close()
+{
+    if (m_file) std::fclose(m_file);
+    m_file = nullptr;
+}
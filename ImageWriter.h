@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Writes 8-bit RGB (channels = 3) or RGBA (channels = 4) pixels as a PNG. Rows are
+// top-to-bottom unless flipVertical is set, which matches glReadPixels output.
+// The image data is stored uncompressed: a fast, dependency-free encoder for frame
+// dumps rather than a small file.
+bool WritePNG(const std::string& path, int width, int height, int channels, const unsigned char* pixels, bool flipVertical);
+
+// Streams frames as raw YUV4MPEG2 (4:2:0, BT.601 limited range), which ffmpeg and
+// most players read directly. Input is 8-bit RGBA.
+class Y4MWriter
+{
+public:
+    Y4MWriter() = default;
+    ~Y4MWriter();
+    Y4MWriter(const Y4MWriter&) = delete;
+    Y4MWriter& operator=(const Y4MWriter&) = delete;
+
+    bool open(const std::string& path, int width, int height, int fps);
+    bool writeFrame(const unsigned char* rgba, bool flipVertical);
+    void close();
+    bool isOpen() const { return m_file != nullptr; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+private:
+    std::FILE* m_file = nullptr;
+    int m_width = 0;
+    int m_height = 0;
+    int m_sourceWidth = 0;
+    int m_sourceHeight = 0;
+    std::vector<unsigned char> m_planes;
+};
@@ -0,0 +1,96 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+static thread_local int t_threadIndex = 0;
+
+JobSystem::~JobSystem()
+{
+    shutdown();
+}
+
+void JobSystem::init(int workers)
+{
+    shutdown();
+    if (workers <= 0) workers = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+    m_quit = false;
+    for (int i = 0; i < workers; ++i)
+        m_workers.emplace_back(&JobSystem::workerLoop, this, i + 1);
+}
+
+void JobSystem::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers) worker.join();
+    m_workers.clear();
+}
+
+void JobSystem::runChunks()
+{
+    for (;;) {
+        size_t begin = m_next.fetch_add(m_chunk, std::memory_order_relaxed);
+        if (begin >= m_count) return;
+        (*m_fn)(begin, std::min(begin + m_chunk, m_count));
+        m_remaining.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+int JobSystem::threadIndex()
+{
+    return t_threadIndex;
+}
+
+void JobSystem::workerLoop(int index)
+{
+    t_threadIndex = index;
+    unsigned int seen = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_wake.wait(lock, [&] { return m_quit || m_generation != seen; });
+        if (m_quit) return;
+        seen = m_generation;
+        ++m_activeWorkers;
+        lock.unlock();
+        runChunks();
+        lock.lock();
+        if (--m_activeWorkers == 0) m_done.notify_all();
+    }
+}
+
+void JobSystem::parallelFor(size_t count, size_t minChunk, const std::function<void(size_t, size_t)>& fn)
+{
+    if (count == 0) return;
+    minChunk = std::max<size_t>(minChunk, 1);
+    const size_t threads = static_cast<size_t>(threadCount());
+    if (threads == 1 || count <= minChunk) {
+        fn(0, count);
+        return;
+    }
+
+    std::lock_guard<std::mutex> submit(m_submitMutex);
+    // A few chunks per thread evens out uneven work without much scheduling overhead.
+    const size_t chunk = std::max(minChunk, (count + threads * 4 - 1) / (threads * 4));
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        // A worker that woke late for the previous batch may still be leaving runChunks.
+        m_done.wait(lock, [&] { return m_activeWorkers == 0; });
+        m_fn = &fn;
+        m_count = count;
+        m_chunk = chunk;
+        m_next.store(0, std::memory_order_relaxed);
+        m_remaining.store((count + chunk - 1) / chunk, std::memory_order_relaxed);
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    runChunks();
+
+    // Wait for the last chunks and for every worker to leave runChunks, so the next batch
+    // can safely reset the shared state.
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [&] { return m_remaining.load(std::memory_order_acquire) == 0 && m_activeWorkers == 0; });
+    m_fn = nullptr;
+}
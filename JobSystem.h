@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed pool of worker threads for data-parallel CPU work (light binning, culling, ...).
+// One parallelFor runs at a time; the calling thread works on it too and returns once
+// every chunk has finished, so callers never see partially processed data.
+class JobSystem
+{
+public:
+    JobSystem() = default;
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // `workers` extra threads; 0 picks hardware_concurrency() - 1.
+    void init(int workers = 0);
+    void shutdown();
+    // Threads that take part in a parallelFor, including the caller.
+    int threadCount() const { return static_cast<int>(m_workers.size()) + 1; }
+
+    // Calls fn(begin, end) over [0, count) in chunks of at least `minChunk` items.
+    void parallelFor(size_t count, size_t minChunk, const std::function<void(size_t, size_t)>& fn);
+
+    // Index of the calling thread inside a parallelFor: 0 for the thread that called it,
+    // 1..threadCount()-1 for workers. Meant for picking per-thread scratch buffers.
+    static int threadIndex();
+
+private:
+    void workerLoop(int index);
+    void runChunks();
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_submitMutex;           // serializes parallelFor calls
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    bool m_quit = false;
+    unsigned int m_generation = 0;      // bumped for every batch so workers notice new work
+
+    // Current batch
+    const std::function<void(size_t, size_t)>* m_fn = nullptr;
+    size_t m_count = 0;
+    size_t m_chunk = 1;
+    std::atomic<size_t> m_next{ 0 };
+    std::atomic<size_t> m_remaining{ 0 };  // chunks not yet finished
+    int m_activeWorkers = 0;            // workers still inside runChunks for this batch
+};
+
+inline JobSystem jobSystem;
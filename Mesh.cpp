@@ -1,50 +1,67 @@
 #include "Mesh.h"
+#include "FrameStats.h"
+#include <algorithm>
+
+static unsigned int nextMeshId = 1;
 
 Mesh::Mesh(const std::vector<Vertex>& verts, const std::vector<unsigned int>& inds)
-    : vertices(verts), indices(inds) {
-    setupMesh();
+    : vertices(verts), indices(inds), m_id(nextMeshId++) {
+    computeBounds();
+    meshPool.allocate(m_range, vertices, indices);
 }
 
 Mesh::~Mesh() {
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
+    meshPool.release(m_range);
+    if (instanceVBO) {
+        meshPool.forgetInstances(instanceVBO);
+        glDeleteBuffers(1, &instanceVBO);
+    }
 }
 
-void Mesh::setupMesh() {
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+void Mesh::computeBounds() {
+    bounds.Min = glm::vec3(0.0f);
+    bounds.Max = glm::vec3(0.0f);
+    if (!vertices.empty()) {
+        bounds.Min = bounds.Max = vertices[0].Position;
+        for (const Vertex& v : vertices) {
+            bounds.Min = glm::min(bounds.Min, v.Position);
+            bounds.Max = glm::max(bounds.Max, v.Position);
+        }
+    }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    bounds.Center = (bounds.Min + bounds.Max) * 0.5f;
+    bounds.Radius = 0.0f;
+    for (const Vertex& v : vertices)
+        bounds.Radius = std::max(bounds.Radius, glm::length(v.Position - bounds.Center));
+}
 
-    // position
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-    glEnableVertexAttribArray(0);
-    // color
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Color));
-    glEnableVertexAttribArray(1);
-    // texcoord
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoord));
-    glEnableVertexAttribArray(2);
+void Mesh::Draw() const {
+    glBindVertexArray(meshPool.vao());
+    glDrawElementsBaseVertex(GL_TRIANGLES, m_range.indexCount, GL_UNSIGNED_INT, indexOffset(), m_range.baseVertex);
+    glBindVertexArray(0);
+    frameStats.glCalls += 3;
+    frameStats.drawCalls++;
+    frameStats.triangles += indices.size() / 3;
+}
 
-    // normal attribute
-    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-    glEnableVertexAttribArray(3);
+void Mesh::SetInstances(const std::vector<InstanceData>& instances) {
+    if (!instanceVBO) glGenBuffers(1, &instanceVBO);
 
-    glBindVertexArray(0);
+    // Re-specifying the whole store orphans the previous one instead of waiting on the GPU.
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(InstanceData), instances.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    frameStats.glCalls += 3;
 }
 
-void Mesh::Draw() const {
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0);
+void Mesh::DrawInstanced(GLsizei instanceCount) const {
+    glBindVertexArray(meshPool.vao());
+    meshPool.bindInstances(instanceVBO, false);
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, m_range.indexCount, GL_UNSIGNED_INT, indexOffset(), instanceCount, m_range.baseVertex);
     glBindVertexArray(0);
+    frameStats.glCalls += 3;
+    frameStats.drawCalls++;
+    frameStats.triangles += static_cast<unsigned long long>(indices.size() / 3) * instanceCount;
 }
 
 Mesh* Mesh::CreateTriangle() {
@@ -184,7 +201,33 @@ Mesh* Mesh::CreateBackdropPlane() {
     return new Mesh(verts, inds);
 }
 
+Mesh* Mesh::CreateSphere(float radius, int slices, int stacks) {
+    const float PI = 3.1415926f;
+    std::vector<Vertex> verts;
+    std::vector<unsigned int> inds;
+    verts.reserve((slices + 1) * (stacks + 1));
+    inds.reserve(slices * stacks * 6);
+
+    for (int stack = 0; stack <= stacks; ++stack) {
+        float v = static_cast<float>(stack) / stacks;
+        float phi = v * PI;
+        for (int slice = 0; slice <= slices; ++slice) {
+            float u = static_cast<float>(slice) / slices;
+            float theta = u * 2.0f * PI;
+            glm::vec3 normal(sin(phi) * cos(theta), cos(phi), sin(phi) * sin(theta));
+            glm::vec3 color = glm::vec3(0.5f) + 0.5f * normal;
+            verts.emplace_back(normal * radius, color, glm::vec2(u, 1.0f - v), normal);
+        }
+    }
 
+    // Counter-clockwise seen from outside.
+    for (int stack = 0; stack < stacks; ++stack) {
+        for (int slice = 0; slice < slices; ++slice) {
+            unsigned int i0 = stack * (slices + 1) + slice;
+            unsigned int i1 = i0 + slices + 1;
+            inds.insert(inds.end(), { i0, i0 + 1, i1, i1, i0 + 1, i1 + 1 });
+        }
+    }
 
-
-
+    return new Mesh(verts, inds);
+}
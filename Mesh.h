@@ -2,6 +2,7 @@
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <vector>
+#include "MeshPool.h"
 
 struct Vertex {
     glm::vec3 Position;
@@ -18,24 +19,65 @@ struct Vertex {
     }
 };
 
+// Per-instance attributes streamed alongside the mesh for DrawInstanced (locations 4-11).
+struct InstanceData {
+    glm::mat4 Model;
+    glm::vec4 Tint;
+    glm::mat3 NormalMatrix;     // see ComputeNormalMatrices
+};
+
+// Object-space bounding volumes, computed once from the vertex positions.
+struct Bounds {
+    glm::vec3 Min;
+    glm::vec3 Max;
+    glm::vec3 Center;   // bounding sphere
+    float Radius;
+};
+
+// CPU copy of the geometry plus a handle to where the pool keeps it on the GPU. All meshes
+// share meshPool's buffers and VAOs; drawing one means passing its base vertex and first index.
 class Mesh {
 public:
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
+    Bounds bounds;
 
     Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
     ~Mesh();
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
 
     void Draw() const;
 
+    // Uploads per-instance data into this mesh's own buffer; the shared VAO is pointed at it
+    // (MeshPool::bindInstances) right before an instanced draw.
+    void SetInstances(const std::vector<InstanceData>& instances);
+    void DrawInstanced(GLsizei instanceCount) const;
+
+    unsigned int vao() const { return meshPool.vao(); }
+    // Positions only (location 0, plus the instance transform at 4-7) from a tightly packed
+    // buffer, for passes that write nothing but depth.
+    unsigned int depthVao() const { return meshPool.depthVao(); }
+    unsigned int instanceBuffer() const { return instanceVBO; }
+    // Creation order; tells meshes apart in RenderQueue sort keys now that they share VAOs.
+    unsigned int id() const { return m_id; }
+    GLsizei indexCount() const { return m_range.indexCount; }
+    GLint baseVertex() const { return m_range.baseVertex; }
+    // Byte offset of the first index in the shared index buffer, as glDrawElements* takes it.
+    const void* indexOffset() const { return (const void*)(m_range.firstIndex * sizeof(unsigned int)); }
+
     // Factory method: create triangle mesh
     static Mesh* CreateTriangle();
     static Mesh* CreateQuad();
     static Mesh* CreateCircle(float radius = 0.5f, int segments = 64);
     static Mesh* CreatePyramid();
     static Mesh* CreateBackdropPlane();
+    // Dense UV sphere (slices x stacks quads) used by the vertex-heavy benchmark scene.
+    static Mesh* CreateSphere(float radius = 0.5f, int slices = 96, int stacks = 48);
 
 private:
-    unsigned int VAO, VBO, EBO;
-    void setupMesh();
+    unsigned int m_id;
+    MeshRange m_range;
+    unsigned int instanceVBO = 0;
+    void computeBounds();
 };
@@ -0,0 +1,50 @@
+#include "MeshLod.h"
+#include <algorithm>
+#include <cmath>
+
+// Largest gap between an arc of `radius` and the chord of a segment spanning `angle`.
+static float chordError(float radius, float angle)
+{
+    return radius * (1.0f - std::cos(angle * 0.5f));
+}
+
+MeshLod::~MeshLod()
+{
+    for (Mesh* mesh : m_levels) delete mesh;
+}
+
+void MeshLod::addLevel(Mesh* mesh, float error)
+{
+    m_levels.push_back(mesh);
+    m_errors.push_back(error);
+}
+
+MeshLod* MeshLod::CreateCircle(float radius, int segments, int minSegments)
+{
+    const float PI = 3.1415926f;
+    MeshLod* lod = new MeshLod();
+    for (int n = segments; n >= std::max(minSegments, 3); n /= 2)
+        lod->addLevel(Mesh::CreateCircle(radius, n), chordError(radius, 2.0f * PI / n));
+    return lod;
+}
+
+MeshLod* MeshLod::CreateSphere(float radius, int slices, int stacks, int minSlices)
+{
+    const float PI = 3.1415926f;
+    MeshLod* lod = new MeshLod();
+    for (; slices >= std::max(minSlices, 3) && stacks >= 2; slices /= 2, stacks /= 2) {
+        float error = std::max(chordError(radius, 2.0f * PI / slices), chordError(radius, PI / stacks));
+        lod->addLevel(Mesh::CreateSphere(radius, slices, stacks), error);
+    }
+    return lod;
+}
+
+int MeshLod::select(float pixelsPerUnit, float maxPixelError, int current) const
+{
+    int level = std::clamp(current, 0, levelCount() - 1);
+    while (level > 0 && m_errors[level] * pixelsPerUnit > maxPixelError)
+        level--;
+    while (level + 1 < levelCount() && m_errors[level + 1] * pixelsPerUnit <= maxPixelError * kHysteresis)
+        level++;
+    return level;
+}
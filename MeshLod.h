@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+#include "Mesh.h"
+
+// Pre-built detail levels of one procedural shape, finest first. Each level records its
+// geometric error: how far, in object units, its surface can stray from the exact shape.
+// The renderer scales that by the object's projected size to get an error in pixels and
+// draws the coarsest level that keeps it under a limit.
+class MeshLod
+{
+public:
+    // A coarser level is only taken once its error drops to this fraction of the limit, so
+    // an object sitting right at a threshold does not flip between two levels every frame.
+    static constexpr float kHysteresis = 0.7f;
+
+    MeshLod() = default;
+    ~MeshLod();
+    MeshLod(const MeshLod&) = delete;
+    MeshLod& operator=(const MeshLod&) = delete;
+
+    // Segment (slice) counts halve from level to level down to the minimum.
+    static MeshLod* CreateCircle(float radius = 0.5f, int segments = 64, int minSegments = 8);
+    static MeshLod* CreateSphere(float radius = 0.5f, int slices = 96, int stacks = 48, int minSlices = 8);
+
+    int levelCount() const { return static_cast<int>(m_levels.size()); }
+    Mesh* level(int index) const { return m_levels[index]; }
+    float error(int index) const { return m_errors[index]; }
+
+    // Level for an object covering `pixelsPerUnit` screen pixels per object-space unit, keeping
+    // its error under `maxPixelError` pixels. `current` is the level the object had last frame.
+    int select(float pixelsPerUnit, float maxPixelError, int current) const;
+
+private:
+    void addLevel(Mesh* mesh, float error);
+
+    std::vector<Mesh*> m_levels;
+    std::vector<float> m_errors;
+};
@@ -0,0 +1,285 @@
+#include "MeshPool.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include "FrameStats.h"
+#include "Mesh.h"
+
+void RangeAllocator::reset(GLsizei capacity)
+{
+    m_free.clear();
+    if (capacity > 0) m_free.push_back({ 0, capacity });
+    m_capacity = capacity;
+    m_used = 0;
+}
+
+GLint RangeAllocator::allocate(GLsizei count)
+{
+    if (count <= 0) return 0;
+    for (size_t i = 0; i < m_free.size(); ++i) {
+        Block& block = m_free[i];
+        if (block.count < count) continue;
+        GLint offset = block.offset;
+        block.offset += count;
+        block.count -= count;
+        if (block.count == 0) m_free.erase(m_free.begin() + i);
+        m_used += count;
+        return offset;
+    }
+    return -1;
+}
+
+void RangeAllocator::release(GLint offset, GLsizei count)
+{
+    if (count <= 0) return;
+    auto next = std::lower_bound(m_free.begin(), m_free.end(), offset,
+        [](const Block& block, GLint value) { return block.offset < value; });
+    next = m_free.insert(next, { offset, count });
+    m_used -= count;
+
+    // Merge with the following block, then with the preceding one.
+    auto after = next + 1;
+    if (after != m_free.end() && next->offset + next->count == after->offset) {
+        next->count += after->count;
+        m_free.erase(after);
+    }
+    if (next != m_free.begin()) {
+        auto before = next - 1;
+        if (before->offset + before->count == next->offset) {
+            before->count += next->count;
+            m_free.erase(next);
+        }
+    }
+}
+
+// Smallest doubling of `capacity` with room for `count` more on top of `used`.
+static GLsizei grownCapacity(GLsizei capacity, GLsizei used, GLsizei count)
+{
+    GLsizei grown = std::max<GLsizei>(capacity, 1);
+    while (grown - used < count) grown *= 2;
+    return grown;
+}
+
+bool MeshPool::allocate(MeshRange& range, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
+{
+    if (!m_vao) create();
+
+    const GLsizei vertexCount = static_cast<GLsizei>(vertices.size());
+    const GLsizei indexCount = static_cast<GLsizei>(indices.size());
+    GLint baseVertex = m_vertices.allocate(vertexCount);
+    GLint firstIndex = m_indices.allocate(indexCount);
+    if (baseVertex < 0 || firstIndex < 0) {
+        if (baseVertex >= 0) m_vertices.release(baseVertex, vertexCount);
+        if (firstIndex >= 0) m_indices.release(firstIndex, indexCount);
+
+        if (m_vertices.available() >= vertexCount && m_indices.available() >= indexCount) {
+            defragment();
+        }
+        else {
+            relocate(grownCapacity(m_vertices.capacity(), m_vertices.used(), vertexCount),
+                grownCapacity(m_indices.capacity(), m_indices.used(), indexCount));
+            m_growths++;
+        }
+        baseVertex = m_vertices.allocate(vertexCount);
+        firstIndex = m_indices.allocate(indexCount);
+        if (baseVertex < 0 || firstIndex < 0) {
+            std::cerr << "Mesh pool: no room for " << vertexCount << " vertices and " << indexCount << " indices\n";
+            if (baseVertex >= 0) m_vertices.release(baseVertex, vertexCount);
+            if (firstIndex >= 0) m_indices.release(firstIndex, indexCount);
+            range = MeshRange();
+            return false;
+        }
+    }
+
+    std::vector<glm::vec3> positions;
+    positions.reserve(vertices.size());
+    for (const Vertex& v : vertices) positions.push_back(v.Position);
+
+    // The copy-write target leaves the bound VAO's element buffer alone.
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_vbo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, baseVertex * sizeof(Vertex), vertexCount * sizeof(Vertex), vertices.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_positionVbo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, baseVertex * sizeof(glm::vec3), vertexCount * sizeof(glm::vec3), positions.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_ebo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, firstIndex * sizeof(unsigned int), indexCount * sizeof(unsigned int), indices.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    range.baseVertex = baseVertex;
+    range.vertexCount = vertexCount;
+    range.firstIndex = static_cast<GLuint>(firstIndex);
+    range.indexCount = indexCount;
+    m_ranges.push_back(&range);
+    return true;
+}
+
+void MeshPool::release(MeshRange& range)
+{
+    auto it = std::find(m_ranges.begin(), m_ranges.end(), &range);
+    if (it == m_ranges.end()) return;
+    m_vertices.release(range.baseVertex, range.vertexCount);
+    m_indices.release(static_cast<GLint>(range.firstIndex), range.indexCount);
+    *it = m_ranges.back();
+    m_ranges.pop_back();
+    range = MeshRange();
+}
+
+void MeshPool::defragment()
+{
+    if (!m_vao) return;
+    relocate(m_vertices.capacity(), m_indices.capacity());
+    m_defragmentations++;
+}
+
+void MeshPool::create()
+{
+    glGenVertexArrays(1, &m_vao);
+    glGenVertexArrays(1, &m_depthVao);
+    relocate(kInitialVertices, kInitialIndices);
+}
+
+void MeshPool::relocate(GLsizei vertexCapacity, GLsizei indexCapacity)
+{
+    GLuint vbo, positionVbo, ebo;
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &positionVbo);
+    glGenBuffers(1, &ebo);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+    glBufferData(GL_COPY_WRITE_BUFFER, vertexCapacity * sizeof(Vertex), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, positionVbo);
+    glBufferData(GL_COPY_WRITE_BUFFER, vertexCapacity * sizeof(glm::vec3), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ebo);
+    glBufferData(GL_COPY_WRITE_BUFFER, indexCapacity * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+
+    // Live ranges are packed back to back from the start of the new buffers.
+    m_vertices.reset(vertexCapacity);
+    m_indices.reset(indexCapacity);
+    std::vector<MeshRange> moved;
+    moved.reserve(m_ranges.size());
+    for (const MeshRange* range : m_ranges) {
+        MeshRange to = *range;
+        to.baseVertex = m_vertices.allocate(range->vertexCount);
+        to.firstIndex = static_cast<GLuint>(m_indices.allocate(range->indexCount));
+        moved.push_back(to);
+    }
+
+    auto copy = [&](GLuint from, GLuint to, size_t stride, bool indexData) {
+        glBindBuffer(GL_COPY_READ_BUFFER, from);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, to);
+        for (size_t i = 0; i < m_ranges.size(); ++i) {
+            const MeshRange& src = *m_ranges[i];
+            const MeshRange& dst = moved[i];
+            GLsizei count = indexData ? src.indexCount : src.vertexCount;
+            if (count == 0) continue;
+            GLintptr read = indexData ? src.firstIndex : src.baseVertex;
+            GLintptr write = indexData ? dst.firstIndex : dst.baseVertex;
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, read * stride, write * stride, count * stride);
+        }
+    };
+    if (m_vbo) {
+        copy(m_vbo, vbo, sizeof(Vertex), false);
+        copy(m_positionVbo, positionVbo, sizeof(glm::vec3), false);
+        copy(m_ebo, ebo, sizeof(unsigned int), true);
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    for (size_t i = 0; i < m_ranges.size(); ++i) *m_ranges[i] = moved[i];
+
+    glDeleteBuffers(1, &m_vbo);
+    glDeleteBuffers(1, &m_positionVbo);
+    glDeleteBuffers(1, &m_ebo);
+    m_vbo = vbo;
+    m_positionVbo = positionVbo;
+    m_ebo = ebo;
+    setupVertexArrays();
+}
+
+void MeshPool::setupVertexArrays()
+{
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+    // position
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    glEnableVertexAttribArray(0);
+    // color
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Color));
+    glEnableVertexAttribArray(1);
+    // texcoord
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoord));
+    glEnableVertexAttribArray(2);
+    // normal
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+    glEnableVertexAttribArray(3);
+
+    // Position-only stream sharing the index buffer: 12 bytes per vertex instead of 44.
+    glBindVertexArray(m_depthVao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_positionVbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void MeshPool::bindInstances(GLuint buffer, bool positionOnly)
+{
+    GLuint& source = m_instanceSource[positionOnly ? 1 : 0];
+    if (source == buffer) return;
+    source = buffer;
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    // model matrix, one vec4 column per attribute slot
+    for (int i = 0; i < 4; ++i) {
+        glVertexAttribPointer(4 + i, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(offsetof(InstanceData, Model) + sizeof(glm::vec4) * i));
+        glEnableVertexAttribArray(4 + i);
+        glVertexAttribDivisor(4 + i, 1);
+    }
+    int attributes = 4;
+    // The depth stream only needs the model matrix.
+    if (!positionOnly) {
+        // tint
+        glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offsetof(InstanceData, Tint));
+        glEnableVertexAttribArray(8);
+        glVertexAttribDivisor(8, 1);
+        // normal matrix, one vec3 column per slot
+        for (int i = 0; i < 3; ++i) {
+            glVertexAttribPointer(9 + i, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(offsetof(InstanceData, NormalMatrix) + sizeof(glm::vec3) * i));
+            glEnableVertexAttribArray(9 + i);
+            glVertexAttribDivisor(9 + i, 1);
+        }
+        attributes = 8;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    frameStats.glCalls += 2 + attributes * 3;
+}
+
+void MeshPool::forgetInstances(GLuint buffer)
+{
+    for (GLuint& source : m_instanceSource)
+        if (source == buffer) source = 0;
+}
+
+size_t MeshPool::memoryBytes() const
+{
+    return static_cast<size_t>(m_vertices.capacity()) * (sizeof(Vertex) + sizeof(glm::vec3))
+        + static_cast<size_t>(m_indices.capacity()) * sizeof(unsigned int);
+}
+
+void MeshPool::shutdown()
+{
+    if (m_vao) {
+        glDeleteVertexArrays(1, &m_vao);
+        glDeleteVertexArrays(1, &m_depthVao);
+        glDeleteBuffers(1, &m_vbo);
+        glDeleteBuffers(1, &m_positionVbo);
+        glDeleteBuffers(1, &m_ebo);
+    }
+    m_vao = m_depthVao = m_vbo = m_positionVbo = m_ebo = 0;
+    m_instanceSource[0] = m_instanceSource[1] = 0;
+    m_vertices.reset(0);
+    m_indices.reset(0);
+    m_ranges.clear();
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstddef>
+#include <vector>
+
+struct Vertex;
+
+// Where one mesh lives inside the pool's shared buffers. Indices are stored relative to the
+// mesh, so draws pass baseVertex to glDrawElementsBaseVertex instead of rewriting them.
+struct MeshRange
+{
+    GLint baseVertex = 0;
+    GLsizei vertexCount = 0;
+    GLuint firstIndex = 0;
+    GLsizei indexCount = 0;
+};
+
+// First-fit free list over [0, capacity) elements. Freed blocks merge with their neighbours,
+// so only allocations that are still live can leave holes.
+class RangeAllocator
+{
+public:
+    void reset(GLsizei capacity);
+    // Returns the offset of `count` free elements, or -1 if no free block is large enough.
+    GLint allocate(GLsizei count);
+    void release(GLint offset, GLsizei count);
+
+    GLsizei capacity() const { return m_capacity; }
+    GLsizei used() const { return m_used; }
+    GLsizei available() const { return m_capacity - m_used; }
+    size_t freeBlocks() const { return m_free.size(); }
+
+private:
+    struct Block {
+        GLint offset;
+        GLsizei count;
+    };
+    std::vector<Block> m_free;  // sorted by offset, never adjacent
+    GLsizei m_capacity = 0;
+    GLsizei m_used = 0;
+};
+
+// Vertices and indices of every Mesh, suballocated from one vertex buffer, one position-only
+// buffer (same slots, for depth passes) and one index buffer, drawn through two shared VAOs.
+// Switching meshes is then just a different base vertex and first index instead of a VAO bind.
+//
+// When holes left by released meshes keep an allocation from fitting, the pool compacts the
+// live ranges; when there is not enough room at all, it moves them into larger buffers. Both
+// rewrite the registered MeshRanges in place, so callers must re-read them per draw.
+class MeshPool
+{
+public:
+    static const GLsizei kInitialVertices = 64 * 1024;
+    static const GLsizei kInitialIndices = 192 * 1024;
+
+    MeshPool() = default;
+    MeshPool(const MeshPool&) = delete;
+    MeshPool& operator=(const MeshPool&) = delete;
+
+    // Copies the mesh into the shared buffers and registers `range`, which must stay at the
+    // same address until release(). Needs a current GL context.
+    bool allocate(MeshRange& range, const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+    void release(MeshRange& range);
+    // Moves every live range to the front of the buffers, closing all holes.
+    void defragment();
+    // Deletes the GL objects; call before the context goes away.
+    void shutdown();
+
+    // Locations 0-3 from the full vertex buffer.
+    GLuint vao() const { return m_vao; }
+    // Location 0 only, from the packed position buffer.
+    GLuint depthVao() const { return m_depthVao; }
+
+    // Points the instance attributes of the bound shared VAO at `buffer`: locations 4-11 on
+    // vao(), the model matrix (4-7) on depthVao(). A no-op if they already point there.
+    void bindInstances(GLuint buffer, bool positionOnly);
+    // Call before deleting an instance buffer, so a new buffer reusing its name is re-pointed.
+    void forgetInstances(GLuint buffer);
+
+    size_t meshCount() const { return m_ranges.size(); }
+    const RangeAllocator& vertexSpace() const { return m_vertices; }
+    const RangeAllocator& indexSpace() const { return m_indices; }
+    size_t memoryBytes() const;
+    unsigned int defragmentations() const { return m_defragmentations; }
+    unsigned int growths() const { return m_growths; }
+
+private:
+    void create();
+    void relocate(GLsizei vertexCapacity, GLsizei indexCapacity);
+    void setupVertexArrays();
+
+    GLuint m_vbo = 0;
+    GLuint m_positionVbo = 0;
+    GLuint m_ebo = 0;
+    GLuint m_vao = 0;
+    GLuint m_depthVao = 0;
+    GLuint m_instanceSource[2] = { 0, 0 };  // instance buffer each VAO points at: full, depth
+
+    RangeAllocator m_vertices;
+    RangeAllocator m_indices;
+    std::vector<MeshRange*> m_ranges;
+    unsigned int m_defragmentations = 0;
+    unsigned int m_growths = 0;
+};
+
+inline MeshPool meshPool;
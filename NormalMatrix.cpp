@@ -0,0 +1,86 @@
+#include "NormalMatrix.h"
+#include "Mesh.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define S3D_NORMAL_SSE 1
+#endif
+
+// With columns a, b, c the inverse-transpose is [b x c, c x a, a x b] / det, det = a . (b x c).
+glm::mat3 NormalMatrix(const glm::mat4& model, bool uniformScale)
+{
+    const glm::vec3 a(model[0]), b(model[1]), c(model[2]);
+    if (uniformScale) {
+        float scale2 = glm::dot(a, a);
+        return scale2 > 0.0f ? glm::mat3(a, b, c) * (1.0f / scale2) : glm::mat3(1.0f);
+    }
+
+    glm::vec3 bc = glm::cross(b, c);
+    float det = glm::dot(a, bc);
+    if (det == 0.0f) return glm::mat3(1.0f);
+    float invDet = 1.0f / det;
+    return glm::mat3(bc * invDet, glm::cross(c, a) * invDet, glm::cross(a, b) * invDet);
+}
+
+void ComputeNormalMatrices(InstanceData* instances, size_t count, bool uniformScale)
+{
+    size_t i = 0;
+#if defined(S3D_NORMAL_SSE)
+    // Gather 4 instances into structure-of-arrays registers: m[col][row] holds one element
+    // of the four upper-3x3 matrices.
+    for (; i + 4 <= count; i += 4) {
+        const glm::mat4* models[4] = { &instances[i].Model, &instances[i + 1].Model, &instances[i + 2].Model, &instances[i + 3].Model };
+        __m128 m[3][3];
+        for (int col = 0; col < 3; ++col) {
+            for (int row = 0; row < 3; ++row)
+                m[col][row] = _mm_set_ps((*models[3])[col][row], (*models[2])[col][row], (*models[1])[col][row], (*models[0])[col][row]);
+        }
+
+        __m128 n[3][3];
+        __m128 denom;
+        if (uniformScale) {
+            denom = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][0], m[0][0]), _mm_mul_ps(m[0][1], m[0][1])),
+                _mm_mul_ps(m[0][2], m[0][2]));
+            __m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), denom);
+            for (int col = 0; col < 3; ++col) {
+                for (int row = 0; row < 3; ++row)
+                    n[col][row] = _mm_mul_ps(m[col][row], inv);
+            }
+        }
+        else {
+            // Column k of the result is the cross product of the other two input columns.
+            for (int col = 0; col < 3; ++col) {
+                const __m128* u = m[(col + 1) % 3];
+                const __m128* v = m[(col + 2) % 3];
+                n[col][0] = _mm_sub_ps(_mm_mul_ps(u[1], v[2]), _mm_mul_ps(u[2], v[1]));
+                n[col][1] = _mm_sub_ps(_mm_mul_ps(u[2], v[0]), _mm_mul_ps(u[0], v[2]));
+                n[col][2] = _mm_sub_ps(_mm_mul_ps(u[0], v[1]), _mm_mul_ps(u[1], v[0]));
+            }
+            denom = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][0], n[0][0]), _mm_mul_ps(m[0][1], n[0][1])),
+                _mm_mul_ps(m[0][2], n[0][2]));
+            __m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), denom);
+            for (int col = 0; col < 3; ++col) {
+                for (int row = 0; row < 3; ++row)
+                    n[col][row] = _mm_mul_ps(n[col][row], inv);
+            }
+        }
+
+        alignas(16) float lanes[4];
+        for (int col = 0; col < 3; ++col) {
+            for (int row = 0; row < 3; ++row) {
+                _mm_store_ps(lanes, n[col][row]);
+                for (int k = 0; k < 4; ++k)
+                    instances[i + k].NormalMatrix[col][row] = lanes[k];
+            }
+        }
+        // Degenerate matrices divided by zero above; fall back to identity like the scalar path.
+        int degenerate = _mm_movemask_ps(_mm_cmpeq_ps(denom, _mm_setzero_ps()));
+        for (int k = 0; k < 4; ++k) {
+            if (degenerate & (1 << k)) instances[i + k].NormalMatrix = glm::mat3(1.0f);
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+        instances[i].NormalMatrix = NormalMatrix(instances[i].Model, uniformScale);
+}
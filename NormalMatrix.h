@@ -0,0 +1,13 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+
+struct InstanceData;
+
+// Matrix that transforms normals for `model`: the inverse-transpose of its upper 3x3.
+// Pass `uniformScale` when the transform is only translation, rotation and one scale factor;
+// the inverse-transpose is then the matrix divided by the squared scale, so no inverse is taken.
+glm::mat3 NormalMatrix(const glm::mat4& model, bool uniformScale = false);
+
+// Fills NormalMatrix from Model for a whole instance array, 4 instances per SSE iteration.
+void ComputeNormalMatrices(InstanceData* instances, size_t count, bool uniformScale = false);
@@ -0,0 +1,280 @@
+#include "OcclusionCuller.h"
+#include "JobSystem.h"
+#include "Mesh.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iterator>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define S3D_OCCLUSION_SSE 1
+#endif
+
+BoxBounds TransformBox(const glm::mat4& m, const glm::vec3& min, const glm::vec3& max)
+{
+    // Center moves with the full transform; each half extent spreads over |M| (Arvo).
+    glm::vec3 center = glm::vec3(m * glm::vec4((min + max) * 0.5f, 1.0f));
+    glm::vec3 half = (max - min) * 0.5f;
+    glm::vec3 extent(0.0f);
+    for (int col = 0; col < 3; ++col)
+        extent += glm::abs(glm::vec3(m[col])) * half[col];
+    return { center - extent, center + extent };
+}
+
+void OcclusionCuller::begin(const glm::mat4& viewProjection)
+{
+    m_viewProjection = viewProjection;
+    m_clipVertices.clear();
+    m_triangles.clear();
+    std::fill(m_depth.begin(), m_depth.end(), 1.0f);
+    std::fill(std::begin(m_tileMax), std::end(m_tileMax), 1.0f);
+    m_rasterMs = 0.0;
+    m_testMs = 0.0;
+}
+
+void OcclusionCuller::addOccluder(const Mesh& mesh, const glm::mat4& model)
+{
+    const glm::mat4 mvp = m_viewProjection * model;
+    for (unsigned int index : mesh.indices)
+        m_clipVertices.push_back(mvp * glm::vec4(mesh.vertices[index].Position, 1.0f));
+}
+
+void OcclusionCuller::setupTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+{
+    const glm::vec4* clip[3] = { &a, &b, &c };
+    float x[3], y[3], z[3];
+    for (int i = 0; i < 3; ++i) {
+        float invW = 1.0f / clip[i]->w;
+        x[i] = (clip[i]->x * invW * 0.5f + 0.5f) * kWidth;
+        y[i] = (clip[i]->y * invW * 0.5f + 0.5f) * kHeight;
+        z[i] = clip[i]->z * invW * 0.5f + 0.5f;
+    }
+
+    // Pixel centers sit at +0.5; keep those inside the vertex bounds (the edge tests below are stricter).
+    Triangle tri;
+    tri.minX = std::max(0, static_cast<int>(std::ceil(std::min({ x[0], x[1], x[2] }) - 0.5f)));
+    tri.maxX = std::min(kWidth - 1, static_cast<int>(std::floor(std::max({ x[0], x[1], x[2] }) - 0.5f)));
+    tri.minY = std::max(0, static_cast<int>(std::ceil(std::min({ y[0], y[1], y[2] }) - 0.5f)));
+    tri.maxY = std::min(kHeight - 1, static_cast<int>(std::floor(std::max({ y[0], y[1], y[2] }) - 0.5f)));
+    if (tri.minX > tri.maxX || tri.minY > tri.maxY) return;
+
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+    if (std::fabs(area) < 1e-6f) return;
+    // Occluders are two-sided: flip clockwise triangles so inside is always e >= 0.
+    float sign = area > 0.0f ? 1.0f : -1.0f;
+    float invArea = 1.0f / (area * sign);
+    tri.depthA = tri.depthB = tri.depthC = 0.0f;
+    for (int i = 0; i < 3; ++i) {
+        // Edge opposite vertex i, so e_i / area is that vertex's barycentric weight.
+        int v0 = (i + 1) % 3;
+        int v1 = (i + 2) % 3;
+        tri.edgeA[i] = sign * (y[v0] - y[v1]);
+        tri.edgeB[i] = sign * (x[v1] - x[v0]);
+        tri.edgeC[i] = sign * (x[v0] * y[v1] - y[v0] * x[v1]);
+        tri.depthA += tri.edgeA[i] * invArea * z[i];
+        tri.depthB += tri.edgeB[i] * invArea * z[i];
+        tri.depthC += tri.edgeC[i] * invArea * z[i];
+    }
+    // Stay conservative: a center sample only counts if the whole pixel square is inside
+    // every edge, and it stores the farthest depth the plane reaches within that square.
+    for (int i = 0; i < 3; ++i)
+        tri.edgeC[i] -= 0.5f * (std::fabs(tri.edgeA[i]) + std::fabs(tri.edgeB[i]));
+    tri.depthC += 0.5f * (std::fabs(tri.depthA) + std::fabs(tri.depthB));
+    m_triangles.push_back(tri);
+}
+
+void OcclusionCuller::rasterize()
+{
+    auto start = std::chrono::steady_clock::now();
+
+    // Clip against the near plane (z >= -w), which also keeps w positive for the divide.
+    for (size_t t = 0; t + 2 < m_clipVertices.size(); t += 3) {
+        glm::vec4 polygon[4];
+        int count = 0;
+        for (int i = 0; i < 3; ++i) {
+            const glm::vec4& p = m_clipVertices[t + i];
+            const glm::vec4& q = m_clipVertices[t + (i + 1) % 3];
+            float dp = p.z + p.w;
+            float dq = q.z + q.w;
+            if (dp >= 0.0f) polygon[count++] = p;
+            if ((dp >= 0.0f) != (dq >= 0.0f)) polygon[count++] = p + (q - p) * (dp / (dp - dq));
+        }
+        for (int i = 1; i + 1 < count; ++i)
+            setupTriangle(polygon[0], polygon[i], polygon[i + 1]);
+    }
+
+    // Bands of tile rows never share pixels, so they need no synchronization.
+    jobSystem.parallelFor(kTilesY, 1, [this](size_t begin, size_t end) {
+        for (size_t band = begin; band < end; ++band) rasterizeBand(static_cast<int>(band));
+    });
+
+    m_rasterMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void OcclusionCuller::rasterizeBand(int band)
+{
+    const int bandMinY = band * kTileHeight;
+    const int bandMaxY = bandMinY + kTileHeight - 1;
+
+    for (const Triangle& tri : m_triangles) {
+        const int minY = std::max(tri.minY, bandMinY);
+        const int maxY = std::min(tri.maxY, bandMaxY);
+        // Spans start on a 4-pixel boundary; kWidth is a multiple of 4, so they never overrun a row.
+        const int startX = tri.minX & ~3;
+        for (int y = minY; y <= maxY; ++y) {
+            const float py = y + 0.5f;
+            float* row = &m_depth[static_cast<size_t>(y) * kWidth];
+#if defined(S3D_OCCLUSION_SSE)
+            const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(startX)), _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f));
+            __m128 e[3], step[3];
+            for (int i = 0; i < 3; ++i) {
+                e[i] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.edgeA[i]), px), _mm_set1_ps(tri.edgeB[i] * py + tri.edgeC[i]));
+                step[i] = _mm_set1_ps(tri.edgeA[i] * 4.0f);
+            }
+            __m128 depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(tri.depthA), px), _mm_set1_ps(tri.depthB * py + tri.depthC));
+            const __m128 depthStep = _mm_set1_ps(tri.depthA * 4.0f);
+            const __m128 zero = _mm_setzero_ps();
+            for (int x = startX; x <= tri.maxX; x += 4) {
+                __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e[0], zero), _mm_cmpge_ps(e[1], zero)), _mm_cmpge_ps(e[2], zero));
+                if (_mm_movemask_ps(inside)) {
+                    __m128 old = _mm_loadu_ps(row + x);
+                    __m128 nearest = _mm_min_ps(old, depth);
+                    _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, old)));
+                }
+                for (int i = 0; i < 3; ++i) e[i] = _mm_add_ps(e[i], step[i]);
+                depth = _mm_add_ps(depth, depthStep);
+            }
+#else
+            for (int x = startX; x <= tri.maxX; ++x) {
+                const float px = x + 0.5f;
+                bool inside = true;
+                for (int i = 0; i < 3 && inside; ++i)
+                    inside = tri.edgeA[i] * px + tri.edgeB[i] * py + tri.edgeC[i] >= 0.0f;
+                if (inside) row[x] = std::min(row[x], tri.depthA * px + tri.depthB * py + tri.depthC);
+            }
+#endif
+        }
+    }
+
+    // Farthest depth per tile for the coarse test.
+    for (int tx = 0; tx < kTilesX; ++tx) {
+        float farthest = 0.0f;
+        for (int y = bandMinY; y <= bandMaxY; ++y) {
+            const float* row = &m_depth[static_cast<size_t>(y) * kWidth + tx * kTileWidth];
+            for (int x = 0; x < kTileWidth; ++x) farthest = std::max(farthest, row[x]);
+        }
+        m_tileMax[band * kTilesX + tx] = farthest;
+    }
+}
+
+bool OcclusionCuller::isOccluded(const glm::mat4& m, const BoxBounds& box) const
+{
+    // Project the 8 corners, four at a time: x/y alternate within a group, z is per group.
+    float minX, maxX, minY, maxY, nearest;
+#if defined(S3D_OCCLUSION_SSE)
+    const __m128 cx = _mm_setr_ps(box.min.x, box.max.x, box.min.x, box.max.x);
+    const __m128 cy = _mm_setr_ps(box.min.y, box.min.y, box.max.y, box.max.y);
+    __m128 lo[3], hi[3];
+    for (int group = 0; group < 2; ++group) {
+        const __m128 cz = _mm_set1_ps(group == 0 ? box.min.z : box.max.z);
+        __m128 clip[4];
+        for (int r = 0; r < 4; ++r) {
+            clip[r] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[0][r]), cx), _mm_mul_ps(_mm_set1_ps(m[1][r]), cy)),
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[2][r]), cz), _mm_set1_ps(m[3][r])));
+        }
+        // Any corner in front of the near plane: the projected rectangle is not bounded.
+        if (_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(clip[2], clip[3]), _mm_setzero_ps()))) return false;
+        const __m128 invW = _mm_div_ps(_mm_set1_ps(1.0f), clip[3]);
+        for (int r = 0; r < 3; ++r) {
+            __m128 v = _mm_mul_ps(clip[r], invW);
+            lo[r] = group == 0 ? v : _mm_min_ps(lo[r], v);
+            hi[r] = group == 0 ? v : _mm_max_ps(hi[r], v);
+        }
+    }
+    float l[3][4], h[2][4];
+    for (int r = 0; r < 3; ++r) _mm_storeu_ps(l[r], lo[r]);
+    for (int r = 0; r < 2; ++r) _mm_storeu_ps(h[r], hi[r]);
+    minX = std::min({ l[0][0], l[0][1], l[0][2], l[0][3] });
+    minY = std::min({ l[1][0], l[1][1], l[1][2], l[1][3] });
+    nearest = std::min({ l[2][0], l[2][1], l[2][2], l[2][3] });
+    maxX = std::max({ h[0][0], h[0][1], h[0][2], h[0][3] });
+    maxY = std::max({ h[1][0], h[1][1], h[1][2], h[1][3] });
+#else
+    minX = minY = nearest = INFINITY;
+    maxX = maxY = -INFINITY;
+    for (int corner = 0; corner < 8; ++corner) {
+        glm::vec4 clip = m * glm::vec4((corner & 1) ? box.max.x : box.min.x, (corner & 2) ? box.max.y : box.min.y,
+            (corner & 4) ? box.max.z : box.min.z, 1.0f);
+        if (clip.z < -clip.w) return false;
+        minX = std::min(minX, clip.x / clip.w);
+        maxX = std::max(maxX, clip.x / clip.w);
+        minY = std::min(minY, clip.y / clip.w);
+        maxY = std::max(maxY, clip.y / clip.w);
+        nearest = std::min(nearest, clip.z / clip.w);
+    }
+#endif
+    nearest = nearest * 0.5f + 0.5f;
+
+    // Every pixel the rectangle touches, not just covered centers.
+    int x0 = static_cast<int>(std::floor((minX * 0.5f + 0.5f) * kWidth));
+    int x1 = static_cast<int>(std::floor((maxX * 0.5f + 0.5f) * kWidth));
+    int y0 = static_cast<int>(std::floor((minY * 0.5f + 0.5f) * kHeight));
+    int y1 = static_cast<int>(std::floor((maxY * 0.5f + 0.5f) * kHeight));
+    // Off screen is the frustum test's call.
+    if (x1 < 0 || y1 < 0 || x0 >= kWidth || y0 >= kHeight) return false;
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, kWidth - 1);
+    y1 = std::min(y1, kHeight - 1);
+
+    for (int ty = y0 / kTileHeight; ty <= y1 / kTileHeight; ++ty) {
+        for (int tx = x0 / kTileWidth; tx <= x1 / kTileWidth; ++tx) {
+            if (nearest > m_tileMax[ty * kTilesX + tx]) continue;
+
+            // The tile has something at or behind the box; look at the covered pixels.
+            const int px0 = std::max(x0, tx * kTileWidth);
+            const int px1 = std::min(x1, tx * kTileWidth + kTileWidth - 1);
+            const int py0 = std::max(y0, ty * kTileHeight);
+            const int py1 = std::min(y1, ty * kTileHeight + kTileHeight - 1);
+            for (int y = py0; y <= py1; ++y) {
+                const float* row = &m_depth[static_cast<size_t>(y) * kWidth];
+#if defined(S3D_OCCLUSION_SSE)
+                const __m128 boxDepth = _mm_set1_ps(nearest);
+                const __m128i first = _mm_set1_epi32(px0 - 1);
+                const __m128i last = _mm_set1_epi32(px1 + 1);
+                for (int x = px0 & ~3; x <= px1; x += 4) {
+                    __m128i lane = _mm_add_epi32(_mm_set1_epi32(x), _mm_setr_epi32(0, 1, 2, 3));
+                    __m128 valid = _mm_castsi128_ps(_mm_and_si128(_mm_cmpgt_epi32(lane, first), _mm_cmplt_epi32(lane, last)));
+                    __m128 visible = _mm_cmpge_ps(_mm_loadu_ps(row + x), boxDepth);
+                    if (_mm_movemask_ps(_mm_and_ps(valid, visible))) return false;
+                }
+#else
+                for (int x = px0; x <= px1; ++x) {
+                    if (row[x] >= nearest) return false;
+                }
+#endif
+            }
+        }
+    }
+    return true;
+}
+
+size_t OcclusionCuller::cull(const glm::mat4& modelViewProjection, const std::vector<BoxBounds>& boxes, uint8_t* mask, uint8_t bit)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> occluded{ 0 };
+    jobSystem.parallelFor(boxes.size(), 1024, [&](size_t begin, size_t end) {
+        size_t local = 0;
+        for (size_t i = begin; i < end; ++i) {
+            if ((mask[i] & bit) && isOccluded(modelViewProjection, boxes[i])) {
+                mask[i] &= ~bit;
+                local++;
+            }
+        }
+        occluded += local;
+    });
+    m_testMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return occluded;
+}
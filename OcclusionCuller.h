@@ -0,0 +1,69 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+class Mesh;
+
+struct BoxBounds {
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+// Transforms an axis-aligned box by `m` and returns the axis-aligned box around the result.
+BoxBounds TransformBox(const glm::mat4& m, const glm::vec3& min, const glm::vec3& max);
+
+// Software occlusion culling. A few large occluders are rasterized on the CPU into a
+// kWidth x kHeight depth buffer, 4 pixels at a time, one band of tiles per JobSystem job.
+// Each kTileWidth x kTileHeight tile also keeps its farthest depth, so most boxes are
+// rejected or accepted per tile and only the rest are compared pixel by pixel.
+//
+// Depth is NDC z mapped to [0, 1]; a box is occluded when its nearest corner lies behind
+// the stored depth at every pixel its screen rectangle covers.
+class OcclusionCuller
+{
+public:
+    static constexpr int kWidth = 256;
+    static constexpr int kHeight = 128;
+    static constexpr int kTileWidth = 32;
+    static constexpr int kTileHeight = 8;
+    static constexpr int kTilesX = kWidth / kTileWidth;
+    static constexpr int kTilesY = kHeight / kTileHeight;
+
+    // Clears the buffer and occluder list for a camera with the given view-projection.
+    void begin(const glm::mat4& viewProjection);
+    // Queues every triangle of `mesh` (its CPU-side vertices) placed with `model`.
+    void addOccluder(const Mesh& mesh, const glm::mat4& model);
+    // Clips and rasterizes the queued occluders.
+    void rasterize();
+
+    // `modelViewProjection` maps the box's space to clip space. Boxes crossing the near
+    // plane are never reported as occluded.
+    bool isOccluded(const glm::mat4& modelViewProjection, const BoxBounds& box) const;
+    // Clears `bit` in mask[i] for every box that has it set and is occluded; returns how many were.
+    size_t cull(const glm::mat4& modelViewProjection, const std::vector<BoxBounds>& boxes, uint8_t* mask, uint8_t bit);
+
+    // CPU cost since begin(), wall clock on the calling thread.
+    double rasterMs() const { return m_rasterMs; }
+    double testMs() const { return m_testMs; }
+    size_t triangleCount() const { return m_triangles.size(); }
+
+private:
+    // Screen-space triangle: edge functions and depth plane evaluated at pixel centers.
+    struct Triangle {
+        float edgeA[3], edgeB[3], edgeC[3];     // e = A * x + B * y + C, inside where all >= 0
+        float depthA, depthB, depthC;
+        int minX, maxX, minY, maxY;
+    };
+
+    void setupTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+    void rasterizeBand(int band);
+
+    glm::mat4 m_viewProjection = glm::mat4(1.0f);
+    std::vector<glm::vec4> m_clipVertices;      // queued occluder triangles, clip space
+    std::vector<Triangle> m_triangles;
+    std::vector<float> m_depth = std::vector<float>(kWidth * kHeight, 1.0f);
+    float m_tileMax[kTilesX * kTilesY] = {};
+    double m_rasterMs = 0.0;
+    double m_testMs = 0.0;
+};
@@ -0,0 +1,174 @@
+#include "PostProcess.h"
+#include "Profiler.h"
+#include <algorithm>
+
+// Texture units the post shaders sample from.
+static const GLint kSourceUnit = 0;
+static const GLint kBloomUnit = 1;
+
+PostProcess::~PostProcess()
+{
+    if (m_vao) glDeleteVertexArrays(1, &m_vao);
+}
+
+bool PostProcess::init()
+{
+    m_resolveShaders.init("shaders/fullscreen.vert", "shaders/post_resolve.frag");
+    m_fxaaShaders.init("shaders/fullscreen.vert", "shaders/fxaa.frag");
+    m_downsampleShaders.init("shaders/fullscreen.vert", "shaders/bloom_downsample.frag");
+    m_upsampleShaders.init("shaders/fullscreen.vert", "shaders/bloom_upsample.frag");
+    for (ShaderVariants* set : { &m_resolveShaders, &m_fxaaShaders, &m_downsampleShaders, &m_upsampleShaders })
+        set->bindSampler("source", kSourceUnit);
+    m_resolveShaders.bindSampler("bloomTexture", kBloomUnit);
+
+    glGenVertexArrays(1, &m_vao);
+    // The default chain; bloom variants compile the first time bloom is switched on.
+    return m_vao != 0 && m_resolveShaders.get(SHADER_TONEMAP) && m_fxaaShaders.get(0);
+}
+
+void PostProcess::appendShaderSets(std::vector<ShaderVariants*>& sets)
+{
+    sets.insert(sets.end(), { &m_resolveShaders, &m_fxaaShaders, &m_downsampleShaders, &m_upsampleShaders });
+}
+
+void PostProcess::beginFullscreen() const
+{
+    glDisable(GL_DEPTH_TEST);
+    glBindVertexArray(m_vao);
+}
+
+void PostProcess::endFullscreen() const
+{
+    glActiveTexture(GL_TEXTURE0 + kBloomUnit);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0 + kSourceUnit);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindVertexArray(0);
+    glEnable(GL_DEPTH_TEST);
+}
+
+void PostProcess::drawFullscreen() const
+{
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+static void bindTexture(GLint unit, GLuint texture)
+{
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+FrameGraphResource PostProcess::addBloomPass(FrameGraph& graph, const SceneSettings& settings, FrameGraphResource scene,
+    int width, int height)
+{
+    ShaderProgram* prefilter = m_downsampleShaders.get(SHADER_PREFILTER);
+    ShaderProgram* downsample = m_downsampleShaders.get(0);
+    ShaderProgram* upsample = m_upsampleShaders.get(0);
+    if (!prefilter || !downsample || !upsample) return FrameGraph::kNoResource;
+
+    // Halve until kMaxBloomMips levels or the next level would drop below 8 pixels.
+    static const char* const kMipNames[kMaxBloomMips] = { "Bloom mip 0", "Bloom mip 1", "Bloom mip 2",
+        "Bloom mip 3", "Bloom mip 4", "Bloom mip 5" };
+    FrameGraphResource mips[kMaxBloomMips];
+    int mipCount = 0;
+    int w = width / 2;
+    int h = height / 2;
+    FrameGraph::Builder pass = graph.addPass("Bloom");
+    pass.read(scene);
+    while (mipCount < kMaxBloomMips && w >= 8 && h >= 8) {
+        mips[mipCount] = pass.create(kMipNames[mipCount], { w, h, GL_R11F_G11F_B10F });
+        mipCount++;
+        w /= 2;
+        h /= 2;
+    }
+    const float threshold = settings.bloomThreshold;
+    pass.setExecute([=, &graph]() {
+        PROFILE_SCOPE("Bloom");
+        PROFILE_GPU_SCOPE("Bloom");
+        beginFullscreen();
+        const RenderTarget* source = &graph.target(scene);
+        for (int i = 0; i < mipCount; ++i) {
+            ShaderProgram* program = i == 0 ? prefilter : downsample;
+            const RenderTarget& mip = graph.target(mips[i]);
+            program->use();
+            program->setVec2(program->uniform("texelSize"), glm::vec2(1.0f / source->width, 1.0f / source->height));
+            program->setFloat(program->uniform("threshold"), threshold);
+            glBindFramebuffer(GL_FRAMEBUFFER, mip.fbo);
+            glViewport(0, 0, mip.width, mip.height);
+            bindTexture(kSourceUnit, source->color);
+            drawFullscreen();
+            source = &mip;
+        }
+
+        // Walk back up, adding each blurred level onto the next larger one.
+        const ShaderProgram::Uniform texelSize = upsample->uniform("texelSize");
+        upsample->use();
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        for (int i = mipCount - 1; i > 0; --i) {
+            const RenderTarget& from = graph.target(mips[i]);
+            const RenderTarget& to = graph.target(mips[i - 1]);
+            upsample->setVec2(texelSize, glm::vec2(1.0f / from.width, 1.0f / from.height));
+            glBindFramebuffer(GL_FRAMEBUFFER, to.fbo);
+            glViewport(0, 0, to.width, to.height);
+            bindTexture(kSourceUnit, from.color);
+            drawFullscreen();
+        }
+        glDisable(GL_BLEND);
+        endFullscreen();
+    });
+    return mipCount > 0 ? mips[0] : FrameGraph::kNoResource;
+}
+
+void PostProcess::addPasses(FrameGraph& graph, const SceneSettings& settings, FrameGraphResource scene,
+    int sceneWidth, int sceneHeight, FrameGraphResource output, int width, int height)
+{
+    FrameGraphResource bloom = settings.bloom
+        ? addBloomPass(graph, settings, scene, sceneWidth, sceneHeight) : FrameGraph::kNoResource;
+
+    uint32_t features = 0;
+    if (settings.tonemap) features |= SHADER_TONEMAP;
+    if (bloom != FrameGraph::kNoResource) features |= SHADER_BLOOM;
+    ShaderProgram* resolve = m_resolveShaders.get(features);
+    ShaderProgram* fxaa = settings.fxaa ? m_fxaaShaders.get(0) : nullptr;
+    if (!resolve) return;
+
+    // FXAA needs the resolved image as a texture; otherwise resolve straight to the output.
+    FrameGraph::Builder resolvePass = graph.addPass("Tonemap");
+    resolvePass.read(scene);
+    resolvePass.read(bloom);
+    const FrameGraphResource ldr = fxaa ? resolvePass.create("LDR", { width, height, GL_RGBA8 }) : resolvePass.write(output);
+    const float exposure = settings.exposure;
+    const float bloomIntensity = settings.bloomIntensity;
+    resolvePass.setExecute([=, &graph]() {
+        PROFILE_SCOPE("Tonemap");
+        PROFILE_GPU_SCOPE("Tonemap");
+        beginFullscreen();
+        resolve->use();
+        resolve->setFloat(resolve->uniform("exposure"), exposure);
+        resolve->setFloat(resolve->uniform("bloomIntensity"), bloomIntensity);
+        glBindFramebuffer(GL_FRAMEBUFFER, graph.target(ldr).fbo);
+        glViewport(0, 0, width, height);
+        if (bloom != FrameGraph::kNoResource) bindTexture(kBloomUnit, graph.target(bloom).color);
+        bindTexture(kSourceUnit, graph.target(scene).color);
+        drawFullscreen();
+        endFullscreen();
+    });
+
+    if (!fxaa) return;
+    FrameGraph::Builder fxaaPass = graph.addPass("FXAA");
+    fxaaPass.read(ldr);
+    fxaaPass.write(output);
+    fxaaPass.setExecute([=, &graph]() {
+        PROFILE_SCOPE("FXAA");
+        PROFILE_GPU_SCOPE("FXAA");
+        beginFullscreen();
+        fxaa->use();
+        fxaa->setVec2(fxaa->uniform("texelSize"), glm::vec2(1.0f / width, 1.0f / height));
+        glBindFramebuffer(GL_FRAMEBUFFER, graph.target(output).fbo);
+        glViewport(0, 0, width, height);
+        bindTexture(kSourceUnit, graph.target(ldr).color);
+        drawFullscreen();
+        endFullscreen();
+    });
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <GL/glew.h>
+#include <vector>
+#include "FrameGraph.h"
+#include "SceneSettings.h"
+#include "ShaderVariants.h"
+
+// Turns the HDR scene target into the final image: optional bloom over a downsampled
+// mip chain, then tonemapping, then FXAA. Every effect can be switched off on its own
+// (SceneSettings) and is its own frame graph pass, timed as its own GPU profiler pass.
+// Intermediate targets are frame graph transients.
+class PostProcess
+{
+public:
+    static constexpr int kMaxBloomMips = 6;
+
+    PostProcess() = default;
+    ~PostProcess();
+    PostProcess(const PostProcess&) = delete;
+    PostProcess& operator=(const PostProcess&) = delete;
+
+    bool init();
+
+    // Adds the passes that read `scene` (color only, sceneWidth x sceneHeight) and write the
+    // result to `output`, a width x height target. A smaller scene is upscaled bilinearly
+    // when it is tonemapped; bloom runs at the scene's size.
+    void addPasses(FrameGraph& graph, const SceneSettings& settings, FrameGraphResource scene,
+        int sceneWidth, int sceneHeight, FrameGraphResource output, int width, int height);
+
+    // Adds this stage's shader sets to `sets` (for hot reload, see Renderer::updateShaderReloads).
+    void appendShaderSets(std::vector<ShaderVariants*>& sets);
+
+private:
+    // Returns the half-resolution target that holds the blurred bright pass, or kNoResource.
+    FrameGraphResource addBloomPass(FrameGraph& graph, const SceneSettings& settings, FrameGraphResource scene,
+        int width, int height);
+    void beginFullscreen() const;
+    void endFullscreen() const;
+    void drawFullscreen() const;
+
+    ShaderVariants m_resolveShaders;        // fullscreen.vert + post_resolve.frag
+    ShaderVariants m_fxaaShaders;           // fullscreen.vert + fxaa.frag
+    ShaderVariants m_downsampleShaders;     // fullscreen.vert + bloom_downsample.frag
+    ShaderVariants m_upsampleShaders;       // fullscreen.vert + bloom_upsample.frag
+    GLuint m_vao = 0;                       // empty; the fullscreen triangle has no attributes
+};
@@ -0,0 +1,212 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+static thread_local uint16_t t_scopeDepth = 0;
+static thread_local int t_threadIndex = -1;
+static std::atomic<int> s_nextThreadIndex{ 0 };
+
+static uint64_t steadyNs()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+Profiler::Profiler()
+    : m_slots(kEventCapacity), m_epoch(steadyNs())
+{
+}
+
+uint64_t Profiler::nowNs() const
+{
+    return steadyNs() - m_epoch;
+}
+
+void Profiler::init()
+{
+    if (m_gpuReady) return;
+    for (GpuFrame& f : m_gpuFrames) {
+        glGenQueries(kMaxGpuScopes, f.queries);
+        f.count = 0;
+        f.pending = false;
+    }
+    m_gpuHistory.assign(kGpuHistory, ResolvedGpuFrame());
+    m_gpuHistoryNext = 0;
+    m_gpuReady = true;
+}
+
+void Profiler::shutdown()
+{
+    if (!m_gpuReady) return;
+    if (m_gpuNesting > 0) glEndQuery(GL_TIME_ELAPSED);
+    for (GpuFrame& f : m_gpuFrames)
+        glDeleteQueries(kMaxGpuScopes, f.queries);
+    m_gpuNesting = 0;
+    m_gpuReady = false;
+}
+
+void Profiler::record(const char* name, uint64_t startNs, uint64_t endNs, uint16_t depth)
+{
+    if (t_threadIndex < 0) t_threadIndex = s_nextThreadIndex.fetch_add(1, std::memory_order_relaxed);
+
+    // Claim a slot, then publish it seqlock-style so readers can tell a torn copy.
+    const uint64_t index = m_head.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = m_slots[index & (kEventCapacity - 1)];
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.event.name = name;
+    slot.event.startNs = startNs;
+    slot.event.endNs = endNs;
+    slot.event.frame = m_frame.load(std::memory_order_relaxed);
+    slot.event.thread = static_cast<uint16_t>(t_threadIndex);
+    slot.event.depth = depth;
+    slot.seq.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::collectFrame(uint32_t frame, std::vector<ProfileEvent>& out) const
+{
+    out.clear();
+    const uint64_t head = m_head.load(std::memory_order_acquire);
+    const uint64_t first = head > kEventCapacity ? head - kEventCapacity : 0;
+    for (uint64_t i = first; i < head; ++i) {
+        const Slot& slot = m_slots[i & (kEventCapacity - 1)];
+        if (slot.seq.load(std::memory_order_acquire) != i + 1) continue;
+        ProfileEvent event = slot.event;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != i + 1) continue;
+        if (frame == UINT32_MAX || event.frame == frame) out.push_back(event);
+    }
+    std::sort(out.begin(), out.end(), [](const ProfileEvent& a, const ProfileEvent& b) {
+        return a.startNs < b.startNs;
+    });
+}
+
+void Profiler::beginFrame()
+{
+    const uint32_t frame = m_frame.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (!m_gpuReady) return;
+
+    if (m_gpuNesting > 0) {
+        std::cerr << "Profiler: GPU scope left open at end of frame\n";
+        glEndQuery(GL_TIME_ELAPSED);
+        m_gpuNesting = 0;
+    }
+
+    // The slot being reused was issued kGpuLatency frames ago; its results are normally
+    // ready by now. If not, they are dropped rather than waited for.
+    GpuFrame& slot = m_gpuFrames[frame % kGpuLatency];
+    if (slot.pending) {
+        GLint available = 0;
+        glGetQueryObjectiv(slot.queries[slot.count - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) resolveGpuFrame(slot);
+        else m_droppedGpuFrames++;
+    }
+    slot.frame = frame;
+    slot.cpuStartNs = nowNs();
+    slot.count = 0;
+    slot.pending = false;
+}
+
+void Profiler::resolveGpuFrame(GpuFrame& gpuFrame)
+{
+    ResolvedGpuFrame& resolved = m_gpuHistory[m_gpuHistoryNext];
+    m_gpuHistoryNext = (m_gpuHistoryNext + 1) % m_gpuHistory.size();
+    resolved.frame = gpuFrame.frame;
+    resolved.cpuStartNs = gpuFrame.cpuStartNs;
+    resolved.timings.clear();
+    for (int i = 0; i < gpuFrame.count; ++i) {
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(gpuFrame.queries[i], GL_QUERY_RESULT, &elapsed);
+        resolved.timings.push_back({ gpuFrame.names[i], elapsed / 1.0e6 });
+    }
+    m_lastGpu = resolved.timings;
+    m_lastGpuFrame = resolved.frame;
+}
+
+void Profiler::beginGpu(const char* name)
+{
+    if (!m_gpuReady || m_gpuNesting++ > 0) return;
+    GpuFrame& slot = m_gpuFrames[frameIndex() % kGpuLatency];
+    if (slot.count >= kMaxGpuScopes) {
+        m_gpuNesting = -1000;   // swallow this scope's endGpu()
+        return;
+    }
+    slot.names[slot.count] = name;
+    glBeginQuery(GL_TIME_ELAPSED, slot.queries[slot.count]);
+}
+
+void Profiler::endGpu()
+{
+    if (!m_gpuReady) return;
+    if (m_gpuNesting < 0) {
+        m_gpuNesting = 0;
+        return;
+    }
+    if (--m_gpuNesting > 0) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    GpuFrame& slot = m_gpuFrames[frameIndex() % kGpuLatency];
+    slot.count++;
+    slot.pending = true;
+}
+
+static void writeJsonString(std::FILE* file, const char* s)
+{
+    std::fputc('"', file);
+    for (; s && *s; ++s) {
+        if (*s == '"' || *s == '\\') std::fputc('\\', file);
+        std::fputc(*s, file);
+    }
+    std::fputc('"', file);
+}
+
+bool Profiler::writeChromeTrace(const std::string& path) const
+{
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+        std::cerr << "Profiler: could not write " << path << "\n";
+        return false;
+    }
+
+    std::vector<ProfileEvent> events;
+    collectFrame(UINT32_MAX, events);
+
+    std::fprintf(file, "{\"traceEvents\":[\n");
+    std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"CPU\"}},\n");
+    std::fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"args\":{\"name\":\"GPU (passes laid end to end from frame start)\"}}");
+    for (const ProfileEvent& e : events) {
+        std::fprintf(file, ",\n{\"name\":");
+        writeJsonString(file, e.name);
+        std::fprintf(file, ",\"cat\":\"cpu\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"frame\":%u}}",
+            e.startNs / 1000.0, (e.endNs - e.startNs) / 1000.0, static_cast<unsigned>(e.thread), e.frame);
+    }
+
+    // Elapsed-time queries only give durations, so GPU passes are placed back to back.
+    for (const ResolvedGpuFrame& f : m_gpuHistory) {
+        double ts = f.cpuStartNs / 1000.0;
+        for (const GpuTiming& t : f.timings) {
+            std::fprintf(file, ",\n{\"name\":");
+            writeJsonString(file, t.name);
+            std::fprintf(file, ",\"cat\":\"gpu\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":2,\"tid\":0,\"args\":{\"frame\":%u}}",
+                ts, t.ms * 1000.0, f.frame);
+            ts += t.ms * 1000.0;
+        }
+    }
+    std::fprintf(file, "\n]}\n");
+    bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+    if (ok) std::cout << "Profiler: wrote " << events.size() << " CPU events to " << path << "\n";
+    return ok;
+}
+
+ProfileScope::ProfileScope(const char* name)
+    : m_name(name), m_start(profiler.nowNs()), m_depth(t_scopeDepth++)
+{
+}
+
+ProfileScope::~ProfileScope()
+{
+    t_scopeDepth--;
+    profiler.record(m_name, m_start, profiler.nowNs(), m_depth);
+}
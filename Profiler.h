@@ -0,0 +1,137 @@
+#pragma once
+#include <GL/glew.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One closed CPU scope. Names must be string literals (or otherwise outlive the profiler).
+struct ProfileEvent
+{
+    const char* name = nullptr;
+    uint64_t startNs = 0;       // since Profiler construction
+    uint64_t endNs = 0;
+    uint32_t frame = 0;
+    uint16_t thread = 0;        // small per-thread index, 0 = first thread that recorded
+    uint16_t depth = 0;         // nesting level on that thread
+};
+
+struct GpuTiming
+{
+    const char* name = nullptr;
+    double ms = 0.0;
+};
+
+// Frame profiler: CPU scopes from any thread go into a fixed-size lock-free ring, GPU
+// passes are timed with GL_TIME_ELAPSED queries that are read back kGpuLatency frames
+// later without blocking. Use the PROFILE_SCOPE / PROFILE_GPU_SCOPE macros below.
+class Profiler
+{
+public:
+    static const uint32_t kEventCapacity = 1u << 15;   // power of two
+    static const int kGpuLatency = 4;                   // frames between issuing and reading a query
+    static const int kMaxGpuScopes = 16;                // per frame
+    static const int kGpuHistory = 240;                 // resolved frames kept for trace export
+
+    Profiler();
+
+    // GL-side setup/teardown; call with a current context.
+    void init();
+    void shutdown();
+
+    // Marks the start of a new frame and collects whatever GPU results are ready.
+    void beginFrame();
+    uint32_t frameIndex() const { return m_frame.load(std::memory_order_relaxed); }
+
+    void record(const char* name, uint64_t startNs, uint64_t endNs, uint16_t depth);
+    uint64_t nowNs() const;
+
+    // GL_TIME_ELAPSED queries cannot overlap: a GPU scope opened inside another one is
+    // folded into the outer scope.
+    void beginGpu(const char* name);
+    void endGpu();
+
+    // Copies the CPU events of `frame` still present in the ring, ordered by start time.
+    void collectFrame(uint32_t frame, std::vector<ProfileEvent>& out) const;
+    const std::vector<GpuTiming>& lastGpuTimings() const { return m_lastGpu; }
+    uint32_t lastGpuFrame() const { return m_lastGpuFrame; }
+    uint32_t droppedGpuFrames() const { return m_droppedGpuFrames; }
+
+    // Writes everything still in the ring (plus resolved GPU passes) as Chrome trace JSON,
+    // viewable in chrome://tracing or Perfetto.
+    bool writeChromeTrace(const std::string& path) const;
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> seq{ 0 };     // ring index + 1 once the event is fully written
+        ProfileEvent event;
+    };
+
+    struct GpuFrame {
+        uint32_t frame = 0;
+        uint64_t cpuStartNs = 0;
+        int count = 0;
+        bool pending = false;
+        const char* names[kMaxGpuScopes] = {};
+        GLuint queries[kMaxGpuScopes] = {};
+    };
+
+    struct ResolvedGpuFrame {
+        uint32_t frame = 0;
+        uint64_t cpuStartNs = 0;
+        std::vector<GpuTiming> timings;
+    };
+
+    void resolveGpuFrame(GpuFrame& gpuFrame);
+
+    std::vector<Slot> m_slots;
+    std::atomic<uint64_t> m_head{ 0 };
+    std::atomic<uint32_t> m_frame{ 0 };
+    uint64_t m_epoch = 0;
+
+    bool m_gpuReady = false;
+    GpuFrame m_gpuFrames[kGpuLatency];
+    int m_gpuNesting = 0;
+    std::vector<GpuTiming> m_lastGpu;
+    uint32_t m_lastGpuFrame = 0;
+    uint32_t m_droppedGpuFrames = 0;
+    std::vector<ResolvedGpuFrame> m_gpuHistory;     // ring of kGpuHistory frames
+    size_t m_gpuHistoryNext = 0;
+};
+
+inline Profiler profiler;
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char* name);
+    ~ProfileScope();
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* m_name;
+    uint64_t m_start;
+    uint16_t m_depth;
+};
+
+class GpuProfileScope
+{
+public:
+    explicit GpuProfileScope(const char* name) { profiler.beginGpu(name); }
+    ~GpuProfileScope() { profiler.endGpu(); }
+    GpuProfileScope(const GpuProfileScope&) = delete;
+    GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+};
+
+// SIMPLE3D_PROFILER is set by the SIMPLE3D_PROFILER CMake option; without it the
+// macros compile to nothing.
+#define S3D_PROFILE_CONCAT_(a, b) a##b
+#define S3D_PROFILE_CONCAT(a, b) S3D_PROFILE_CONCAT_(a, b)
+#ifdef SIMPLE3D_PROFILER
+#define PROFILE_SCOPE(name) ProfileScope S3D_PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) GpuProfileScope S3D_PROFILE_CONCAT(gpuProfileScope_, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_GPU_SCOPE(name) ((void)0)
+#endif
@@ -0,0 +1,67 @@
+#include "ProfilerWindow.h"
+#include <imgui.h>
+#include <algorithm>
+#include <cstdio>
+
+static ImU32 colorForName(const char* name)
+{
+    // Stable per-name color so a scope keeps its color from frame to frame.
+    unsigned int hash = 2166136261u;
+    for (const char* c = name; *c; ++c) hash = (hash ^ static_cast<unsigned char>(*c)) * 16777619u;
+    return IM_COL32(90 + hash % 120, 90 + (hash >> 8) % 120, 90 + (hash >> 16) % 120, 255);
+}
+
+void DrawProfilerTimeline(const Profiler& profiler)
+{
+    static std::vector<ProfileEvent> events;
+    const uint32_t frame = profiler.frameIndex() - 1;
+    profiler.collectFrame(frame, events);
+
+    const float width = 420.0f;
+    const float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+
+    if (events.empty()) {
+        ImGui::TextDisabled("No CPU scopes recorded (build with SIMPLE3D_PROFILER)");
+    }
+    else {
+        uint64_t begin = events.front().startNs;
+        uint64_t end = begin;
+        int rows = 1;
+        for (const ProfileEvent& e : events) {
+            end = std::max(end, e.endNs);
+            rows = std::max(rows, (e.thread * 8 + e.depth) + 1);
+        }
+        const double spanNs = std::max<double>(1.0, static_cast<double>(end - begin));
+        ImGui::Text("CPU frame %u: %.3f ms", frame, spanNs / 1.0e6);
+
+        ImDrawList* draw = ImGui::GetWindowDrawList();
+        const ImVec2 origin = ImGui::GetCursorScreenPos();
+        const float height = rows * rowHeight;
+        draw->AddRectFilled(origin, ImVec2(origin.x + width, origin.y + height), IM_COL32(30, 30, 30, 255));
+        for (const ProfileEvent& e : events) {
+            float x0 = origin.x + static_cast<float>((e.startNs - begin) / spanNs) * width;
+            float x1 = origin.x + static_cast<float>((e.endNs - begin) / spanNs) * width;
+            x1 = std::max(x1, x0 + 1.0f);
+            float y0 = origin.y + (e.thread * 8 + e.depth) * rowHeight;
+            ImVec2 a(x0, y0), b(x1, y0 + rowHeight - 1.0f);
+            draw->AddRectFilled(a, b, colorForName(e.name));
+            if (x1 - x0 > ImGui::CalcTextSize(e.name).x + 4.0f)
+                draw->AddText(ImVec2(x0 + 2.0f, y0 + 2.0f), IM_COL32(0, 0, 0, 255), e.name);
+            if (ImGui::IsMouseHoveringRect(a, b))
+                ImGui::SetTooltip("%s: %.3f ms (thread %u)", e.name, (e.endNs - e.startNs) / 1.0e6, static_cast<unsigned>(e.thread));
+        }
+        ImGui::Dummy(ImVec2(width, height));
+    }
+
+    const std::vector<GpuTiming>& gpu = profiler.lastGpuTimings();
+    double gpuTotal = 0.0;
+    for (const GpuTiming& t : gpu) gpuTotal += t.ms;
+    ImGui::Text("GPU frame %u: %.3f ms (dropped %u)", profiler.lastGpuFrame(), gpuTotal, profiler.droppedGpuFrames());
+    for (const GpuTiming& t : gpu) {
+        float fraction = gpuTotal > 0.0 ? static_cast<float>(t.ms / gpuTotal) : 0.0f;
+        char label[64];
+        snprintf(label, sizeof(label), "%s %.3f ms", t.name, t.ms);
+        ImGui::ProgressBar(fraction, ImVec2(width, 0.0f), label);
+    }
+    ImGui::TextDisabled("F9: dump Chrome trace");
+}
@@ -0,0 +1,6 @@
+#pragma once
+#include "Profiler.h"
+
+// Draws the last completed frame's CPU scopes as a flame graph, followed by the most
+// recent GPU pass timings, into the current ImGui window.
+void DrawProfilerTimeline(const Profiler& profiler);
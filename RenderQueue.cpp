@@ -0,0 +1,186 @@
+#include "RenderQueue.h"
+#include "FrameStats.h"
+#include "Mesh.h"
+#include "Profiler.h"
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include <algorithm>
+#include <cstring>
+
+static uint64_t depthBits(float depth)
+{
+    // Non-negative IEEE floats order the same as their bit patterns.
+    if (!(depth > 0.0f)) depth = 0.0f;
+    uint32_t bits;
+    std::memcpy(&bits, &depth, sizeof(bits));
+    return bits;
+}
+
+static GLuint vaoFor(const DrawItem& item)
+{
+    return item.positionOnly ? item.mesh->depthVao() : item.mesh->vao();
+}
+
+uint64_t RenderQueue::makeKey(const DrawItem& item)
+{
+    const uint64_t blend = static_cast<uint64_t>(item.blend) & 0x3;
+    const uint64_t program = item.shader ? (item.shader->id() & 0x3FF) : 0;
+    const uint64_t texture = item.texture ? (item.texture->id() & 0x3FF) : 0;
+    const uint64_t mesh = (item.positionOnly ? 0x200 : 0) | (item.mesh->id() & 0x1FF);
+    const uint64_t depth = depthBits(item.depth);
+
+    if (item.blend != BlendMode::Alpha)
+        return (blend << 62) | (program << 52) | (texture << 42) | (mesh << 32) | depth;
+
+    return (blend << 62) | ((~depth & 0xFFFFFFFFull) << 30) | (program << 20) | (texture << 10) | mesh;
+}
+
+void RenderQueue::push(const DrawItem& item)
+{
+    m_entries.push_back({ makeKey(item), static_cast<uint32_t>(m_items.size()) });
+    m_items.push_back(item);
+    m_sorted = false;
+}
+
+void RenderQueue::append(const DrawList& list)
+{
+    const uint32_t base = static_cast<uint32_t>(m_items.size());
+    m_entries.reserve(m_entries.size() + list.m_keys.size());
+    for (size_t i = 0; i < list.m_keys.size(); ++i)
+        m_entries.push_back({ list.m_keys[i], base + static_cast<uint32_t>(i) });
+    m_items.insert(m_items.end(), list.m_items.begin(), list.m_items.end());
+    if (!list.m_items.empty()) m_sorted = false;
+}
+
+void RenderQueue::clear()
+{
+    m_items.clear();
+    m_entries.clear();
+    m_sorted = false;
+}
+
+void DrawList::push(const DrawItem& item)
+{
+    m_keys.push_back(RenderQueue::makeKey(item));
+    m_items.push_back(item);
+}
+
+void DrawList::clear()
+{
+    m_items.clear();
+    m_keys.clear();
+}
+
+void RenderQueue::radixSort()
+{
+    const size_t n = m_entries.size();
+    m_scratch.resize(n);
+
+    // LSD radix sort, one byte per pass; passes where every key shares the byte are skipped.
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t counts[256] = {};
+        for (const SortEntry& e : m_entries)
+            counts[(e.key >> shift) & 0xFF]++;
+        if (counts[(m_entries[0].key >> shift) & 0xFF] == n) continue;
+
+        size_t offset = 0;
+        for (size_t& c : counts) {
+            size_t count = c;
+            c = offset;
+            offset += count;
+        }
+        for (const SortEntry& e : m_entries)
+            m_scratch[counts[(e.key >> shift) & 0xFF]++] = e;
+        m_entries.swap(m_scratch);
+    }
+}
+
+void RenderQueue::submit()
+{
+    PROFILE_SCOPE("RenderQueue::submit");
+    frameStats.queuedItems += static_cast<unsigned int>(m_items.size());
+    if (m_items.empty()) return;
+
+    if (!m_sorted) {
+        radixSort();
+        m_sorted = true;
+    }
+
+    const ShaderProgram* currentShader = nullptr;
+    // Per-draw uniforms, resolved once per program bind.
+    ShaderProgram::Uniform model = -1, normalMatrix = -1, tint = -1;
+    const Texture* currentTexture = nullptr;
+    GLuint currentVAO = 0;
+    BlendMode currentBlend = BlendMode::Opaque;
+    glDisable(GL_BLEND);
+
+    for (const SortEntry& entry : m_entries) {
+        const DrawItem& item = m_items[entry.index];
+
+        if (item.shader != currentShader) {
+            currentShader = item.shader;
+            model = currentShader->uniform("model");
+            normalMatrix = currentShader->uniform("normalMatrix");
+            tint = currentShader->uniform("tint");
+            currentShader->use();
+            frameStats.programBinds++;
+        }
+
+        if (item.blend != currentBlend) {
+            if (item.blend == BlendMode::Alpha) {
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                frameStats.glCalls += 2;
+            }
+            else if (item.blend == BlendMode::Additive) {
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_ONE, GL_ONE);
+                frameStats.glCalls += 2;
+            }
+            else {
+                glDisable(GL_BLEND);
+                frameStats.glCalls++;
+            }
+            currentBlend = item.blend;
+        }
+
+        if (item.texture && item.texture != currentTexture) {
+            item.texture->bind(GL_TEXTURE0);
+            currentTexture = item.texture;
+            frameStats.textureBinds++;
+        }
+
+        currentShader->setMat4(model, item.model);
+        currentShader->setMat3(normalMatrix, item.normalMatrix);
+        currentShader->setVec3(tint, item.tint);
+
+        if (vaoFor(item) != currentVAO) {
+            currentVAO = vaoFor(item);
+            glBindVertexArray(currentVAO);
+            frameStats.glCalls++;
+            frameStats.vaoBinds++;
+        }
+
+#ifdef SIMPLE3D_PROFILER
+        if (item.profileName) profiler.beginGpu(item.profileName);
+#endif
+        if (item.instanceCount > 0) {
+            meshPool.bindInstances(item.mesh->instanceBuffer(), item.positionOnly);
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES, item.mesh->indexCount(), GL_UNSIGNED_INT,
+                item.mesh->indexOffset(), item.instanceCount, item.mesh->baseVertex());
+        }
+        else {
+            glDrawElementsBaseVertex(GL_TRIANGLES, item.mesh->indexCount(), GL_UNSIGNED_INT,
+                item.mesh->indexOffset(), item.mesh->baseVertex());
+        }
+#ifdef SIMPLE3D_PROFILER
+        if (item.profileName) profiler.endGpu();
+#endif
+        frameStats.glCalls++;
+        frameStats.drawCalls++;
+        frameStats.triangles += static_cast<unsigned long long>(item.mesh->indexCount() / 3) * std::max<GLsizei>(item.instanceCount, 1);
+    }
+
+    glBindVertexArray(0);
+    if (currentBlend != BlendMode::Opaque) glDisable(GL_BLEND);
+}
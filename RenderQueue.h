@@ -0,0 +1,82 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+class Mesh;
+class ShaderProgram;
+class Texture;
+
+enum class BlendMode : uint8_t {
+    Opaque = 0,
+    Alpha = 1,
+    Additive = 2,   // order independent, so sorted like opaque draws
+};
+
+struct DrawItem {
+    const Mesh* mesh = nullptr;
+    const ShaderProgram* shader = nullptr;
+    const Texture* texture = nullptr;   // bound to unit 0; the shader variant decides whether it is sampled
+    BlendMode blend = BlendMode::Opaque;
+    float depth = 0.0f;                 // distance from the camera
+    glm::mat4 model = glm::mat4(1.0f);
+    glm::mat3 normalMatrix = glm::mat3(1.0f);   // see NormalMatrix(); ignored by depth-only shaders
+    glm::vec3 tint = glm::vec3(1.0f);   // vertex color multiplier for non-instanced draws
+    GLsizei instanceCount = 0;          // > 0 draws the mesh's instance buffer
+    bool positionOnly = false;          // draws through Mesh::depthVao() for depth-only shaders
+    const char* profileName = nullptr;  // times this draw as its own GPU pass when set
+};
+
+// Draws recorded away from the GL thread: plain data plus their precomputed sort keys.
+// Each worker fills its own list without locking; RenderQueue::append() merges the lists
+// on the GL thread. Nothing here touches GL.
+class DrawList
+{
+public:
+    void push(const DrawItem& item);
+    void clear();
+    size_t size() const { return m_items.size(); }
+
+private:
+    friend class RenderQueue;
+    std::vector<DrawItem> m_items;
+    std::vector<uint64_t> m_keys;
+};
+
+// Collects a frame's draws, orders them by a 64-bit key and submits them while
+// skipping program/texture/VAO binds and instance re-points that would not change any state.
+//
+// Key layout, most significant bits first:
+//   opaque:      blend(2) | program(10) | texture(10) | mesh(10) | depth(32, front to back)
+//   additive:    same as opaque
+//   translucent: blend(2) | depth(32, back to front) | program(10) | texture(10) | mesh(10)
+// All meshes share the pool's two VAOs, so mesh is the depth-stream bit over the low 9 bits
+// of Mesh::id(): draws of one mesh, and so of one instance buffer, stay together.
+class RenderQueue
+{
+public:
+    void push(const DrawItem& item);
+    // Adds every draw in `list`, reusing its sort keys.
+    void append(const DrawList& list);
+    // Sorts on first call after a push; may be called repeatedly (e.g. once per shadow cascade).
+    void submit();
+    void clear();
+    size_t size() const { return m_items.size(); }
+
+private:
+    friend class DrawList;
+
+    struct SortEntry {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    std::vector<DrawItem> m_items;
+    std::vector<SortEntry> m_entries;
+    std::vector<SortEntry> m_scratch;
+    bool m_sorted = false;
+
+    static uint64_t makeKey(const DrawItem& item);
+    void radixSort();
+};
@@ -0,0 +1,119 @@
+#include "RenderTargetPool.h"
+#include <algorithm>
+#include <iostream>
+
+RenderTargetPool::~RenderTargetPool()
+{
+    for (Entry& entry : m_entries) destroy(*entry.target);
+}
+
+void RenderTargetPool::destroy(RenderTarget& target)
+{
+    glDeleteFramebuffers(1, &target.fbo);
+    glDeleteTextures(1, &target.color);
+    if (target.depth) glDeleteRenderbuffers(1, &target.depth);
+    target = RenderTarget();
+}
+
+size_t RenderTargetPool::bytesPerPixel(GLenum format)
+{
+    switch (format) {
+    case GL_RGBA16F: return 8;
+    case GL_RGBA32F: return 16;
+    case GL_RG16F: return 4;
+    case GL_R16F: return 2;
+    case GL_R8: return 1;
+    default: return 4;     // RGBA8, R11F_G11F_B10F, RGB10_A2, R32F
+    }
+}
+
+size_t RenderTargetPool::targetBytes(int width, int height, GLenum format, bool withDepth)
+{
+    size_t pixels = static_cast<size_t>(width) * height;
+    return pixels * (bytesPerPixel(format) + (withDepth ? 4 : 0));
+}
+
+RenderTarget* RenderTargetPool::acquire(int width, int height, GLenum format, bool withDepth)
+{
+    for (Entry& entry : m_entries) {
+        RenderTarget& t = *entry.target;
+        if (!entry.inUse && t.width == width && t.height == height && t.format == format && entry.depth == withDepth) {
+            entry.inUse = true;
+            entry.lastUsed = m_frame;
+            return entry.target.get();
+        }
+    }
+
+    auto target = std::make_unique<RenderTarget>();
+    target->width = width;
+    target->height = height;
+    target->format = format;
+
+    glGenTextures(1, &target->color);
+    glBindTexture(GL_TEXTURE_2D, target->color);
+    // Storage only; the format/type pair just has to be valid for the internal format.
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &target->fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, target->fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target->color, 0);
+    if (withDepth) {
+        glGenRenderbuffers(1, &target->depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, target->depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, target->depth);
+    }
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Render target " << width << "x" << height << " (format 0x" << std::hex << format << std::dec
+                  << ") incomplete: 0x" << std::hex << status << std::dec << "\n";
+        destroy(*target);
+        return nullptr;
+    }
+
+    Entry entry;
+    entry.target = std::move(target);
+    entry.depth = withDepth;
+    entry.inUse = true;
+    entry.lastUsed = m_frame;
+    m_entries.push_back(std::move(entry));
+    m_created++;
+    return m_entries.back().target.get();
+}
+
+void RenderTargetPool::release(RenderTarget* target)
+{
+    for (Entry& entry : m_entries) {
+        if (entry.target.get() == target) {
+            entry.inUse = false;
+            return;
+        }
+    }
+}
+
+void RenderTargetPool::endFrame()
+{
+    m_frame++;
+    m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(), [this](Entry& entry) {
+        if (entry.inUse || m_frame - entry.lastUsed <= kMaxIdleFrames) return false;
+        destroy(*entry.target);
+        return true;
+    }), m_entries.end());
+}
+
+size_t RenderTargetPool::memoryBytes() const
+{
+    size_t bytes = 0;
+    for (const Entry& entry : m_entries) {
+        const RenderTarget& t = *entry.target;
+        bytes += targetBytes(t.width, t.height, t.format, entry.depth);
+    }
+    return bytes;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// A framebuffer with one color texture (linear filtering, clamped) and an optional
+// depth renderbuffer. Owned by RenderTargetPool.
+struct RenderTarget
+{
+    GLuint fbo = 0;
+    GLuint color = 0;
+    GLuint depth = 0;           // 0 when created without depth
+    int width = 0;
+    int height = 0;
+    GLenum format = GL_RGBA8;   // color internal format
+};
+
+// Hands out render targets by size + format + depth and takes them back at the end of
+// their use, so passes that need the same kind of target share one set of GL objects
+// instead of each owning their own. Targets nobody acquired for kMaxIdleFrames frames
+// (after a resize, or an effect being switched off) are deleted in endFrame().
+class RenderTargetPool
+{
+public:
+    static constexpr unsigned int kMaxIdleFrames = 60;
+
+    RenderTargetPool() = default;
+    ~RenderTargetPool();
+    RenderTargetPool(const RenderTargetPool&) = delete;
+    RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+    // Returns a free matching target, creating it if there is none; nullptr if the
+    // framebuffer is incomplete.
+    RenderTarget* acquire(int width, int height, GLenum format, bool withDepth = false);
+    void release(RenderTarget* target);
+    void endFrame();
+
+    size_t targetCount() const { return m_entries.size(); }
+    size_t memoryBytes() const;
+    unsigned int created() const { return m_created; }   // since startup; stays flat when reuse works
+
+    static size_t bytesPerPixel(GLenum format);
+    // GPU memory of one target: color plus a 24-bit depth buffer (counted as 4 bytes per pixel).
+    static size_t targetBytes(int width, int height, GLenum format, bool withDepth);
+
+private:
+    struct Entry {
+        std::unique_ptr<RenderTarget> target;
+        bool depth = false;
+        bool inUse = false;
+        unsigned int lastUsed = 0;
+    };
+
+    static void destroy(RenderTarget& target);
+
+    std::vector<Entry> m_entries;
+    unsigned int m_frame = 0;
+    unsigned int m_created = 0;
+};
@@ -0,0 +1,752 @@
+#include "Renderer.h"
+#include "FrameData.h"
+#include "FrameStats.h"
+#include "JobSystem.h"
+#include "NormalMatrix.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+// Culling mask bits: seen by the camera, or by at least one shadow cascade.
+static const uint8_t kCameraBit = 1;
+static const uint8_t kShadowBit = 2;
+
+Renderer::~Renderer()
+{
+    delete m_triangle;
+    delete m_rectangle;
+    delete m_circleLods;
+    delete m_pyramid;
+    delete m_sphereLods;
+    delete m_backdrop;
+}
+
+bool Renderer::init(const Config& config)
+{
+    if (config.getBool("shader_cache", true))
+        shaderCache.init(config.getString("shader_cache_dir", "shader_cache"));
+
+    bool ok = true;
+    auto shaderStart = std::chrono::steady_clock::now();
+    m_basicShaders.init("shaders/basic.vert", "shaders/basic.frag");
+    m_basicShaders.bindUniformBlock("FrameData", kFrameDataBinding);
+    m_depthShaders.init("shaders/shadow_depth.vert", "shaders/shadow_depth.frag");
+    m_depthShaders.bindUniformBlock("FrameData", kFrameDataBinding);
+    m_prepassShaders.init("shaders/depth_prepass.vert", "shaders/shadow_depth.frag");
+    m_prepassShaders.bindUniformBlock("FrameData", kFrameDataBinding);
+    m_overdrawShaders.init("shaders/basic.vert", "shaders/overdraw.frag");
+    m_overdrawShaders.bindUniformBlock("FrameData", kFrameDataBinding);
+    m_shaderSets = { &m_basicShaders, &m_depthShaders, &m_prepassShaders, &m_overdrawShaders };
+    // Only the base variants are built up front; the rest compile the first time a draw needs them.
+    m_basicShaders.bindSampler("tex0", 0);
+    m_basicShaders.bindSampler("shadowMap", kShadowMapUnit);
+    m_basicShaders.bindSampler("clusterLights", kClusterLightsUnit);
+    m_basicShaders.bindSampler("clusterGrid", kClusterGridUnit);
+    m_basicShaders.bindSampler("clusterIndices", kClusterIndexUnit);
+    ok &= m_basicShaders.get(0) != nullptr;
+    ok &= depthProgram(0).program != nullptr;
+    double shaderMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - shaderStart).count();
+    // A run with no misses is a warm start: everything came from the binary cache.
+    std::cout << "Shader programs ready in " << shaderMs << " ms ("
+              << (shaderCache.enabled() ? (shaderCache.misses() == 0 ? "warm" : "cold") : "cache off") << ": "
+              << shaderCache.hits() << " cached, " << shaderCache.misses() << " compiled)\n";
+
+    // Camera and lighting are identical for every draw, so they go through one UBO per frame.
+    ok &= m_frameUniforms.init(sizeof(FrameData));
+    m_shadedFragments.init();
+    m_frameTimer.init();
+    m_dynamicResolution.configure(config.getFloat("dynamic_resolution_min_scale", 0.5f),
+        config.getFloat("dynamic_resolution_max_scale", 1.0f), config.getFloat("dynamic_resolution_target_ms", 16.0f));
+
+    m_postReady = m_postProcess.init();
+    m_postProcess.appendShaderSets(m_shaderSets);
+    if (!m_postReady) std::cerr << "Post-processing unavailable; rendering straight to the target\n";
+
+    m_clusteredReady = m_clusteredLights.init();
+    if (!m_clusteredReady) std::cerr << "Clustered lighting unavailable\n";
+
+    m_shadowMapReady = m_shadowMap.init(config.getInt("shadow_map_size", 2048), config.getInt("shadow_cascades", 3));
+    m_shadowDistance = config.getFloat("shadow_distance", 20.0f);
+
+    m_texturePath = config.getString("texture_path", "textures/Metal/Metal053C_1K-JPG_Color.jpg");
+
+    m_triangle = Mesh::CreateTriangle();
+    m_rectangle = Mesh::CreateQuad();
+    m_circleLods = MeshLod::CreateCircle();
+    m_pyramid = Mesh::CreatePyramid();
+    m_sphereLods = MeshLod::CreateSphere();
+    m_backdrop = Mesh::CreateBackdropPlane();
+
+    glEnable(GL_DEPTH_TEST);
+    return ok;
+}
+
+bool Renderer::enableShaderHotReload(std::function<void()> onChange)
+{
+    if (!m_shaderWatcher.start("shaders", std::move(onChange))) return false;
+    std::cout << "Watching shaders/ for changes\n";
+    return true;
+}
+
+void Renderer::updateShaderReloads()
+{
+    if (m_shaderWatcher.hasChanges()) {
+        std::vector<std::string> changed = m_shaderWatcher.takeChanges();
+        // Any touched file, including shared #includes, reloads every variant built from it.
+        for (ShaderVariants* set : m_shaderSets) {
+            if (std::any_of(changed.begin(), changed.end(), [&](const std::string& name) { return set->usesFile(name); }))
+                set->beginReload();
+        }
+    }
+
+    for (ShaderVariants* set : m_shaderSets) {
+        if (!set->reloadPending()) continue;
+        PROFILE_SCOPE("Shader reload poll");
+        set->pollReloads();
+    }
+}
+
+bool Renderer::shaderReloadBusy() const
+{
+    if (m_shaderWatcher.hasChanges()) return true;
+    for (const ShaderVariants* set : m_shaderSets) {
+        if (set->reloadPending()) return true;
+    }
+    return false;
+}
+
+Renderer::DepthProgram& Renderer::depthProgram(uint32_t features)
+{
+    DepthProgram& depth = m_depthPrograms[(features & SHADER_INSTANCED) ? 1 : 0];
+    if (!depth.program) {
+        depth.program = m_depthShaders.get(features);
+        if (depth.program) depth.cascade = depth.program->uniform("cascade");
+    }
+    return depth;
+}
+
+bool Renderer::loadTexture()
+{
+    m_texture = m_resources.getTexture(m_texturePath);
+    return m_texture != nullptr;
+}
+
+// Cheap integer hash mapped to [0, 1); gives every light stable pseudo-random parameters.
+static float hash01(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return (x & 0xFFFFFF) / 16777216.0f;
+}
+
+void Renderer::updatePointLights(int count, float time, bool animate)
+{
+    // Lights circle the origin at different radii, heights and speeds above the backdrop.
+    const float PI = 3.1415926f;
+    m_pointLights.resize(count);
+    for (int i = 0; i < count; ++i) {
+        const uint32_t seed = static_cast<uint32_t>(i) * 4u;
+        float orbit = 0.4f + 3.0f * hash01(seed);
+        float speed = (0.2f + 0.6f * hash01(seed + 1)) * ((i & 1) ? 1.0f : -1.0f);
+        float angle = 2.0f * PI * hash01(seed + 2) + (animate ? time * speed : 0.0f);
+        float hue = hash01(seed + 3);
+
+        PointLight& light = m_pointLights[i];
+        light.position = glm::vec3(cos(angle) * orbit, -0.5f + 1.2f * hash01(seed ^ 0x9e3779b9u), sin(angle) * orbit);
+        light.radius = 0.5f + 0.5f * hash01(seed ^ 0x85ebca6bu);
+        light.color = 0.6f * glm::vec3(
+            0.5f + 0.5f * cos(2.0f * PI * hue),
+            0.5f + 0.5f * cos(2.0f * PI * (hue + 0.333f)),
+            0.5f + 0.5f * cos(2.0f * PI * (hue + 0.667f)));
+    }
+}
+
+Mesh* Renderer::shapeMesh(ShapeType shape) const
+{
+    switch (shape) {
+    case TRIANGLE: return m_triangle;
+    case RECTANGLE: return m_rectangle;
+    case CIRCLE: return m_circleLods->level(0);
+    case PYRAMID: return m_pyramid;
+    case SPHERE: return m_sphereLods->level(0);
+    }
+    return m_triangle;
+}
+
+const MeshLod* Renderer::shapeLods(ShapeType shape) const
+{
+    switch (shape) {
+    case CIRCLE: return m_circleLods;
+    case SPHERE: return m_sphereLods;
+    default: return nullptr;
+    }
+}
+
+// Detail level for one object. `mvp` takes its object space to clip space, `scale` is its
+// uniform scale and `pixelsPerUnit` the screen pixels per world unit at clip w = 1.
+static int selectLod(const MeshLod& lods, const glm::mat4& mvp, const glm::vec3& center, float scale,
+    float pixelsPerUnit, float maxPixelError, int current)
+{
+    // Visible objects reaching behind the near plane get the finest level.
+    const float w = std::max((mvp * glm::vec4(center, 1.0f)).w, 1e-3f);
+    return lods.select(scale * pixelsPerUnit / w, maxPixelError, current);
+}
+
+// Detail level for a shadow caster that is off screen, where its projected size means nothing:
+// its distance from the camera stands in for the depth, with the same hysteresis. Casters
+// behind the camera get the coarsest level. `toWorld` takes its object space to world space.
+static int selectCasterLod(const MeshLod& lods, const glm::mat4& mvp, const glm::mat4& toWorld,
+    const glm::vec3& center, float scale, const glm::vec3& cameraPos, float pixelsPerUnit, float maxPixelError,
+    int current)
+{
+    if ((mvp * glm::vec4(center, 1.0f)).w <= 0.0f) return lods.levelCount() - 1;
+    const float distance = std::max(glm::length(cameraPos - glm::vec3(toWorld * glm::vec4(center, 1.0f))), 1e-3f);
+    return lods.select(scale * pixelsPerUnit / distance, maxPixelError, current);
+}
+
+void Renderer::recordDrawPackets(const PacketTemplates& templates, const MeshLod* lods, const glm::mat4& sceneModel,
+    const glm::vec3& cameraPos)
+{
+    PROFILE_SCOPE("Draw packets");
+    using Clock = std::chrono::steady_clock;
+    m_drawLists.resize(jobSystem.threadCount());
+    for (ThreadDrawLists& lists : m_drawLists) {
+        lists.surface.clear();
+        lists.shadow.clear();
+        lists.prepass.clear();
+    }
+
+    const glm::mat3 sceneNormal = NormalMatrix(sceneModel, true);
+    Clock::time_point start = Clock::now();
+    jobSystem.parallelFor(m_instances.size(), 256, [&](size_t begin, size_t end) {
+        PROFILE_SCOPE("Record draw packets");
+        ThreadDrawLists& lists = m_drawLists[JobSystem::threadIndex()];
+        for (size_t i = begin; i < end; ++i) {
+            const uint8_t bits = m_instanceMask[i];
+            if (bits == 0) continue;
+            const glm::mat4 model = sceneModel * m_instances[i].Model;
+            Mesh* mesh = lods ? lods->level(m_instanceLods[i]) : nullptr;
+            DrawItem item;
+            if ((bits & kShadowBit) && templates.shadow.shader) {
+                item = templates.shadow;
+                if (mesh) item.mesh = mesh;
+                item.model = model;
+                lists.shadow.push(item);
+            }
+            if (!(bits & kCameraBit)) continue;
+
+            const float depth = glm::length(cameraPos - glm::vec3(model[3]));
+            if (templates.prepass.shader) {
+                item = templates.prepass;
+                if (mesh) item.mesh = mesh;
+                item.model = model;
+                item.depth = depth;
+                lists.prepass.push(item);
+            }
+            if (templates.surface.shader) {
+                item = templates.surface;
+                if (mesh) item.mesh = mesh;
+                item.model = model;
+                // Same split as the instanced shader: the scene's rotation, then the instance's own.
+                item.normalMatrix = sceneNormal * m_instances[i].NormalMatrix;
+                item.tint = glm::vec3(m_instances[i].Tint);
+                item.depth = depth;
+                lists.surface.push(item);
+            }
+        }
+    });
+    Clock::time_point recorded = Clock::now();
+
+    // Lists are appended in thread order; the queues sort by key afterwards anyway.
+    m_packetStats.packets = 0;
+    for (const ThreadDrawLists& lists : m_drawLists) {
+        m_renderQueue.append(lists.surface);
+        m_shadowQueue.append(lists.shadow);
+        m_prepassQueue.append(lists.prepass);
+        m_packetStats.packets += lists.surface.size() + lists.shadow.size() + lists.prepass.size();
+    }
+    m_packetStats.recordMs = std::chrono::duration<double, std::milli>(recorded - start).count();
+    m_packetStats.mergeMs = std::chrono::duration<double, std::milli>(Clock::now() - recorded).count();
+    m_packetStats.threads = jobSystem.threadCount();
+}
+
+void Renderer::renderFrame(const SceneSettings& scene, const SimState& state, int width, int height, GLuint targetFramebuffer)
+{
+    PROFILE_SCOPE("Renderer::renderFrame");
+    // Pick this frame's scene size from the GPU time of frames that have finished.
+    double gpuMs = -1.0;
+    m_frameTimer.takeResult(gpuMs);
+    m_dynamicResolution.update(scene.dynamicResolution, gpuMs);
+    m_dynamicResolution.scaledSize(width, height, m_renderWidth, m_renderHeight);
+    const int renderWidth = m_renderWidth;
+    const int renderHeight = m_renderHeight;
+    m_frameTimer.begin();
+
+    glm::vec3 lightPresets[] = {
+        glm::normalize(glm::vec3(-0.5f, 1.0f, 0.3f)),
+        glm::normalize(glm::vec3(1.0f, -1.0f, -0.2f)),
+        glm::normalize(glm::vec3(0.0f, 0.0f, -1.0f))
+    };
+    glm::vec3 lightDir = scene.animateLight
+        ? glm::normalize(glm::vec3(cos(state.lightAngle), 1.0f, sin(state.lightAngle))) : lightPresets[scene.lightPreset];
+    glm::vec3 effectiveLight = scene.lightColor * scene.lightIntensity;
+    glm::vec3 cameraPos = glm::vec3(0.0f, 0.0f, 2.0f);
+
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    float nearPlane = -1.0f, farPlane = 1.0f; // identity projection spans z in [-1, 1]
+    if (scene.is3DMode) {
+        nearPlane = 0.1f;
+        farPlane = 100.0f;
+        view = glm::lookAt(cameraPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        projection = glm::perspective(glm::radians(45.0f), static_cast<float>(width) / height, nearPlane, farPlane);
+    }
+
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, state.objectOffset);
+
+    glm::mat4 backdropModel = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.6f, 0.0f));
+
+    if (scene.toggleSpin)
+        model = glm::rotate(model, state.spinAngle, scene.is3DMode ? glm::vec3(0.3f, 1.0f, 0.0f) : glm::vec3(0.0f, 0.0f, 1.0f));
+
+    const bool shadowsEnabled = scene.shadowsEnabled && m_shadowMapReady;
+
+    // Set common uniforms
+    FrameData frameData = {};
+    frameData.view = view;
+    frameData.projection = projection;
+    frameData.lightDir = glm::vec4(lightDir, 0.0f);
+    frameData.lightColor = glm::vec4(effectiveLight, 1.0f);
+    frameData.viewPos = glm::vec4(cameraPos, 1.0f);
+    frameData.time = state.time;
+    if (shadowsEnabled) {
+        m_shadowMap.update(view, projection, nearPlane, farPlane, m_shadowDistance, scene.is3DMode, lightDir);
+        for (int c = 0; c < m_shadowMap.cascades(); ++c) {
+            frameData.lightSpace[c] = m_shadowMap.lightSpace(c);
+            frameData.cascadeSplits[c] = m_shadowMap.splitDepth(c);
+        }
+        frameData.shadowParams = glm::vec4(static_cast<float>(m_shadowMap.cascades()),
+            static_cast<float>(scene.shadowPcfRadius), 1.0f / m_shadowMap.resolution(), 0.0f);
+    }
+    // Point lights need a perspective camera for the depth slices.
+    const bool pointLights = scene.pointLights && scene.is3DMode && m_clusteredReady;
+    if (pointLights) {
+        updatePointLights(scene.pointLightCount, state.lightAngle, scene.animateLight);
+        m_clusteredLights.update(m_pointLights, view, projection, nearPlane, farPlane);
+        frameData.clusterSize = m_clusteredLights.sizeParams();
+        frameData.clusterParams = m_clusteredLights.sliceParams(renderWidth, renderHeight);
+    }
+    m_frameUniforms.upload(&frameData, sizeof(FrameData), kFrameDataBinding);
+
+    const Texture* drawTexture = (scene.useTexture && m_texture) ? m_texture.get() : nullptr;
+    Mesh* shape = shapeMesh(scene.shape);
+    // Procedural shapes draw the level that matches their size on screen. `shape` stays the
+    // finest one; culling uses its bounds for every level.
+    const MeshLod* lods = scene.meshLod ? shapeLods(scene.shape) : nullptr;
+    const float pixelsPerUnit = projection[1][1] * renderHeight * 0.5f;
+    m_lodCounts.assign(lods ? lods->levelCount() : 0, 0);
+    m_shapeDraws.clear();
+
+    // Frusta used by the culling stage: the camera, plus every shadow cascade for casters.
+    Frustum cameraFrustum = Frustum::FromMatrix(projection * view);
+    Frustum cascadeFrusta[ShadowMap::kMaxCascades];
+    const int cascadeCount = shadowsEnabled ? m_shadowMap.cascades() : 0;
+    for (int c = 0; c < cascadeCount; ++c)
+        cascadeFrusta[c] = Frustum::FromMatrix(m_shadowMap.lightSpace(c));
+
+    m_sceneCuller.clear();
+    glm::vec3 sphereCenter;
+    float sphereRadius;
+    TransformSphere(backdropModel, m_backdrop->bounds.Center, m_backdrop->bounds.Radius, sphereCenter, sphereRadius);
+    m_sceneCuller.add(sphereCenter, sphereRadius);
+    TransformSphere(model, shape->bounds.Center, shape->bounds.Radius, sphereCenter, sphereRadius);
+    m_sceneCuller.add(sphereCenter, sphereRadius);
+    uint8_t sceneMask[2] = { 0, 0 };
+    m_sceneCuller.cull(cameraFrustum, sceneMask, kCameraBit);
+    for (int c = 0; c < cascadeCount; ++c)
+        m_sceneCuller.cull(cascadeFrusta[c], sceneMask, kShadowBit);
+    const bool backdropVisible = (sceneMask[0] & kCameraBit) != 0;
+    const bool backdropCasts = (sceneMask[0] & kShadowBit) != 0;
+    bool shapeVisible = (sceneMask[1] & kCameraBit) != 0;
+    bool shapeCasts = (sceneMask[1] & kShadowBit) != 0;
+
+    // The backdrop is the one large occluder. With the identity 2D projection it is seen edge-on
+    // and hides nothing, so occlusion culling only runs for the 3D camera.
+    const bool occlusion = scene.occlusionCulling && scene.is3DMode && backdropVisible;
+    m_occlusionRan = occlusion;
+    if (occlusion) {
+        PROFILE_SCOPE("Occlusion raster");
+        m_occlusionCuller.begin(projection * view);
+        m_occlusionCuller.addOccluder(*m_backdrop, backdropModel);
+        m_occlusionCuller.rasterize();
+    }
+
+    GLsizei drawInstances = 0;
+    GLsizei shadowInstances = 0;
+    if (scene.instancedScene) {
+        PROFILE_SCOPE("Instance culling");
+        const int instanceCount = scene.instanceCount;
+        if (m_builtInstanceCount != instanceCount || m_builtInstanceMesh != shape) {
+            // Lay the instances out on a square grid covering [-1, 1] so it fits both 2D and 3D views.
+            int side = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(instanceCount))));
+            float cell = 2.0f / side;
+            m_instances.resize(instanceCount);
+            m_instanceBoxes.resize(instanceCount);
+            m_instanceCuller.clear();
+            m_instanceCuller.reserve(instanceCount);
+            for (int i = 0; i < instanceCount; ++i) {
+                int col = i % side;
+                int row = i / side;
+                glm::vec3 pos(-1.0f + cell * (col + 0.5f), -1.0f + cell * (row + 0.5f), 0.0f);
+                glm::mat4 m = glm::translate(glm::mat4(1.0f), pos);
+                m_instances[i].Model = glm::scale(m, glm::vec3(cell * 0.8f));
+                m_instances[i].Tint = glm::vec4(
+                    0.6f + 0.4f * sin(i * 0.37f),
+                    0.6f + 0.4f * sin(i * 0.53f + 2.0f),
+                    0.6f + 0.4f * sin(i * 0.71f + 4.0f), 1.0f);
+                TransformSphere(m_instances[i].Model, shape->bounds.Center, shape->bounds.Radius, sphereCenter, sphereRadius);
+                m_instanceCuller.add(sphereCenter, sphereRadius);
+                m_instanceBoxes[i] = TransformBox(m_instances[i].Model, shape->bounds.Min, shape->bounds.Max);
+            }
+            // Grid instances are translate + uniform scale.
+            ComputeNormalMatrices(m_instances.data(), m_instances.size(), true);
+            m_instanceLods.assign(instanceCount, 0);
+            m_builtInstanceCount = instanceCount;
+            m_builtInstanceMesh = shape;
+        }
+
+        // Test in the scene's model space so the stored bounds never need re-transforming.
+        m_instanceMask.assign(m_instances.size(), 0);
+        m_instanceCuller.cull(Frustum::FromMatrix(projection * view * model), m_instanceMask.data(), kCameraBit);
+        for (int c = 0; c < cascadeCount; ++c)
+            m_instanceCuller.cull(Frustum::FromMatrix(m_shadowMap.lightSpace(c) * model), m_instanceMask.data(), kShadowBit);
+        // Hidden instances lose only the camera bit; they may still cast shadows.
+        if (occlusion)
+            frameStats.occludedObjects += static_cast<unsigned int>(
+                m_occlusionCuller.cull(projection * view * model, m_instanceBoxes, m_instanceMask.data(), kCameraBit));
+
+        if (lods) {
+            PROFILE_SCOPE("LOD selection");
+            const glm::mat4 mvp = projection * view * model;
+            for (size_t i = 0; i < m_instances.size(); ++i) {
+                if (!m_instanceMask[i]) continue;
+                // Uniform scale, so the first column's length is the instance's scale.
+                const glm::mat4& m = m_instances[i].Model;
+                const float scale = glm::length(glm::vec3(m[0]));
+                if (!(m_instanceMask[i] & kCameraBit)) {
+                    m_instanceLods[i] = static_cast<uint8_t>(selectCasterLod(*lods, mvp * m, model * m,
+                        shape->bounds.Center, scale, cameraPos, pixelsPerUnit, scene.lodPixelError, m_instanceLods[i]));
+                    continue;
+                }
+                m_instanceLods[i] = static_cast<uint8_t>(selectLod(*lods, mvp * m, shape->bounds.Center,
+                    scale, pixelsPerUnit, scene.lodPixelError, m_instanceLods[i]));
+                m_lodCounts[m_instanceLods[i]]++;
+            }
+        }
+
+        if (scene.separateDraws) {
+            // Every object becomes its own draw packet; see recordDrawPackets below.
+            for (uint8_t bits : m_instanceMask) {
+                drawInstances += (bits & kCameraBit) ? 1 : 0;
+                shadowInstances += (bits & kShadowBit) ? 1 : 0;
+            }
+        }
+        else {
+            // Per detail level, camera-visible instances first, then shadow-only casters: the
+            // main pass draws the first range and the shadow pass draws both from that level's buffer.
+            const int levels = lods ? lods->levelCount() : 1;
+            for (int level = 0; level < levels; ++level) {
+                m_visibleInstances.clear();
+                for (size_t i = 0; i < m_instances.size(); ++i) {
+                    if ((m_instanceMask[i] & kCameraBit) && (!lods || m_instanceLods[i] == level))
+                        m_visibleInstances.push_back(m_instances[i]);
+                }
+                const GLsizei levelDraws = static_cast<GLsizei>(m_visibleInstances.size());
+                for (size_t i = 0; i < m_instances.size(); ++i) {
+                    if (m_instanceMask[i] == kShadowBit && (!lods || m_instanceLods[i] == level))
+                        m_visibleInstances.push_back(m_instances[i]);
+                }
+                const GLsizei levelShadows = static_cast<GLsizei>(m_visibleInstances.size());
+                if (levelShadows == 0) continue;
+                Mesh* mesh = lods ? lods->level(level) : shape;
+                mesh->SetInstances(m_visibleInstances);
+                m_shapeDraws.push_back({ mesh, levelDraws, levelShadows });
+                drawInstances += levelDraws;
+                shadowInstances += levelShadows;
+            }
+        }
+
+        frameStats.visibleObjects += drawInstances;
+        frameStats.culledObjects += static_cast<unsigned int>(m_instances.size()) - drawInstances;
+        shapeVisible = drawInstances > 0;
+        shapeCasts = shadowInstances > 0;
+    }
+    else {
+        if (occlusion && shapeVisible && m_occlusionCuller.isOccluded(projection * view * model, { shape->bounds.Min, shape->bounds.Max })) {
+            shapeVisible = false;
+            frameStats.occludedObjects++;
+        }
+        frameStats.visibleObjects += shapeVisible ? 1 : 0;
+        frameStats.culledObjects += shapeVisible ? 0 : 1;
+        if (lods) {
+            if (shapeVisible) {
+                m_shapeLod = selectLod(*lods, projection * view * model, shape->bounds.Center, 1.0f, pixelsPerUnit,
+                    scene.lodPixelError, m_shapeLod);
+                m_lodCounts[m_shapeLod]++;
+            }
+            else {
+                m_shapeLod = selectCasterLod(*lods, projection * view * model, model, shape->bounds.Center, 1.0f,
+                    cameraPos, pixelsPerUnit, scene.lodPixelError, m_shapeLod);
+            }
+        }
+        m_shapeDraws.push_back({ lods ? lods->level(m_shapeLod) : shape, 0, 0 });
+    }
+    frameStats.visibleObjects += backdropVisible ? 1 : 0;
+    frameStats.culledObjects += backdropVisible ? 0 : 1;
+
+    // Per-draw shader variants: features that are off for a draw are compiled out.
+    // The separate-draw scene records one draw packet per object instead of the shape's draw below.
+    const bool packets = scene.instancedScene && scene.separateDraws;
+    uint32_t shapeFeatures = 0;
+    if (scene.instancedScene && !packets) shapeFeatures |= SHADER_INSTANCED;
+    uint32_t surfaceFeatures = 0;
+    if (shadowsEnabled) surfaceFeatures |= SHADER_SHADOW;
+    if (drawTexture) surfaceFeatures |= SHADER_TEXTURED;
+    if (pointLights) surfaceFeatures |= SHADER_CLUSTERED;
+
+    // GPU work is declared as frame graph passes; the graph drops the ones nothing reads
+    // (e.g. shadows in the overdraw view) and allocates the transient targets.
+    m_frameGraph.reset();
+    RenderTarget windowTarget;
+    windowTarget.fbo = targetFramebuffer;
+    windowTarget.width = width;
+    windowTarget.height = height;
+    const FrameGraphResource output = m_frameGraph.importTarget("Output", windowTarget);
+    m_frameGraph.markOutput(output);
+
+    // With post-processing the scene goes to an HDR target and is resolved into the output at the end;
+    // a scaled-down scene without it goes to its own target and is stretched onto the output.
+    const bool post = scene.postProcess && m_postReady;
+    const bool scaled = renderWidth != width || renderHeight != height;
+    FrameGraph::Builder clearPass = m_frameGraph.addPass("Clear");
+    const FrameGraphResource sceneColor = post
+        ? clearPass.create("Scene HDR", { renderWidth, renderHeight, GL_RGBA16F, true })
+        : scaled ? clearPass.create("Scene", { renderWidth, renderHeight, GL_RGBA8, true })
+        : clearPass.write(output);
+    clearPass.setExecute([&]() {
+        glBindFramebuffer(GL_FRAMEBUFFER, m_frameGraph.target(sceneColor).fbo);
+        glViewport(0, 0, renderWidth, renderHeight);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    });
+
+    //SHADOW PASS
+    FrameGraphResource shadowMap = FrameGraph::kNoResource;
+    if (shadowsEnabled) {
+        RenderTarget shadowTarget;
+        shadowTarget.width = shadowTarget.height = m_shadowMap.resolution();
+        shadowTarget.format = GL_DEPTH_COMPONENT24;
+        shadowMap = m_frameGraph.importTarget("Shadow map", shadowTarget);
+        FrameGraph::Builder shadowPass = m_frameGraph.addPass("Shadow");
+        shadowPass.write(shadowMap);
+        shadowPass.setExecute([&]() {
+            PROFILE_SCOPE("Shadow pass");
+            PROFILE_GPU_SCOPE("Shadow");
+            DepthProgram& backdropDepth = depthProgram(0);
+            DepthProgram& shapeDepth = depthProgram(shapeFeatures);
+            DrawItem caster;
+            caster.positionOnly = true;
+            if (backdropCasts && backdropDepth.program) {
+                caster.mesh = m_backdrop;
+                caster.shader = backdropDepth.program;
+                caster.model = backdropModel;
+                m_shadowQueue.push(caster);
+            }
+
+            if (shapeCasts && shapeDepth.program && !packets) {
+                caster.shader = shapeDepth.program;
+                caster.model = model;
+                for (const ShapeDraw& draw : m_shapeDraws) {
+                    caster.mesh = draw.mesh;
+                    caster.instanceCount = draw.shadowInstances;
+                    m_shadowQueue.push(caster);
+                }
+            }
+
+            // Flat shapes have no back faces to cull, so bias depth with polygon offset instead.
+            glEnable(GL_POLYGON_OFFSET_FILL);
+            glPolygonOffset(2.0f, 4.0f);
+            for (int c = 0; c < m_shadowMap.cascades(); ++c) {
+                m_shadowMap.beginCascade(c);
+                for (DepthProgram& depth : m_depthPrograms) {
+                    if (!depth.program) continue;
+                    depth.program->use();
+                    depth.program->setInt(depth.cascade, c);
+                }
+                m_shadowQueue.submit();
+            }
+            glDisable(GL_POLYGON_OFFSET_FILL);
+            m_shadowMap.end();
+            m_shadowQueue.clear();
+        });
+    }
+
+    //DEPTH PRE-PASS
+    // Final depth from the position-only stream with no color writes; the shading pass then
+    // tests GL_EQUAL so only the front-most surface of each pixel runs the lighting shader.
+    const bool prepass = scene.depthPrepass;
+    if (prepass) {
+        FrameGraph::Builder prepassPass = m_frameGraph.addPass("Depth prepass");
+        prepassPass.write(sceneColor);
+        prepassPass.setExecute([&]() {
+            PROFILE_SCOPE("Depth prepass");
+            PROFILE_GPU_SCOPE("Depth prepass");
+            DrawItem occluder;
+            occluder.positionOnly = true;
+            occluder.shader = m_prepassShaders.get(0);
+            if (backdropVisible && occluder.shader) {
+                occluder.mesh = m_backdrop;
+                occluder.model = backdropModel;
+                occluder.depth = glm::length(cameraPos - glm::vec3(backdropModel[3]));
+                m_prepassQueue.push(occluder);
+            }
+            occluder.shader = m_prepassShaders.get(shapeFeatures);
+            if (shapeVisible && occluder.shader && !packets) {
+                occluder.model = model;
+                occluder.depth = glm::length(cameraPos - glm::vec3(model[3]));
+                for (const ShapeDraw& draw : m_shapeDraws) {
+                    if (scene.instancedScene && draw.drawInstances == 0) continue;
+                    occluder.mesh = draw.mesh;
+                    occluder.instanceCount = draw.drawInstances;
+                    m_prepassQueue.push(occluder);
+                }
+            }
+
+            glBindFramebuffer(GL_FRAMEBUFFER, m_frameGraph.target(sceneColor).fbo);
+            glViewport(0, 0, renderWidth, renderHeight);
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            m_prepassQueue.submit();
+            m_prepassQueue.clear();
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        });
+    }
+
+    // The overdraw view keeps the same geometry and depth state but only counts fragments.
+    ShaderVariants& surfaceShaders = scene.overdrawView ? m_overdrawShaders : m_basicShaders;
+    if (scene.overdrawView) surfaceFeatures = 0;
+
+    if (packets) {
+        PacketTemplates templates;
+        templates.surface.mesh = shape;
+        templates.surface.shader = surfaceShaders.get(surfaceFeatures);
+        templates.surface.texture = scene.overdrawView ? nullptr : drawTexture;
+        templates.surface.blend = scene.overdrawView ? BlendMode::Additive : BlendMode::Opaque;
+        if (shadowsEnabled) {
+            templates.shadow.mesh = shape;
+            templates.shadow.positionOnly = true;
+            templates.shadow.shader = depthProgram(0).program;
+        }
+        if (prepass) {
+            templates.prepass.mesh = shape;
+            templates.prepass.positionOnly = true;
+            templates.prepass.shader = m_prepassShaders.get(0);
+        }
+        recordDrawPackets(templates, lods, model, cameraPos);
+    }
+
+    FrameGraph::Builder shadingPass = m_frameGraph.addPass("Shading");
+    if (surfaceFeatures & SHADER_SHADOW) shadingPass.read(shadowMap);
+    if (prepass) shadingPass.read(sceneColor);
+    shadingPass.write(sceneColor);
+    shadingPass.setExecute([&]() {
+        glBindFramebuffer(GL_FRAMEBUFFER, m_frameGraph.target(sceneColor).fbo);
+        glViewport(0, 0, renderWidth, renderHeight);
+        if (surfaceFeatures & SHADER_SHADOW) m_shadowMap.bindTexture(GL_TEXTURE0 + kShadowMapUnit);
+        if (pointLights) m_clusteredLights.bindTextures();
+        if (prepass) {
+            glDepthFunc(GL_EQUAL);
+            glDepthMask(GL_FALSE);
+        }
+
+        DrawItem item;
+        item.texture = drawTexture;
+        if (scene.overdrawView) {
+            item.texture = nullptr;
+            item.blend = BlendMode::Additive;
+        }
+
+        //BACKDROP
+        item.shader = surfaceShaders.get(surfaceFeatures);
+        if (backdropVisible && item.shader) {
+            item.mesh = m_backdrop;
+            item.model = backdropModel;
+            item.normalMatrix = NormalMatrix(backdropModel, true);
+            item.profileName = "Backdrop";
+            item.depth = glm::length(cameraPos - glm::vec3(backdropModel[3]));
+            m_renderQueue.push(item);
+        }
+
+        //MAIN OBJECT
+        item.shader = surfaceShaders.get(surfaceFeatures | shapeFeatures);
+        if (shapeVisible && item.shader && !packets) {
+            item.model = model;
+            item.normalMatrix = NormalMatrix(model, true);     // translation and rotation only
+            item.profileName = "Main object";
+            item.depth = glm::length(cameraPos - glm::vec3(model[3]));
+            for (const ShapeDraw& draw : m_shapeDraws) {
+                if (scene.instancedScene && draw.drawInstances == 0) continue;
+                item.mesh = draw.mesh;
+                item.instanceCount = draw.drawInstances;
+                m_renderQueue.push(item);
+            }
+        }
+
+        m_shadedFragments.begin();
+        m_renderQueue.submit();
+        m_shadedFragments.end();
+        m_renderQueue.clear();
+
+        if (prepass) {
+            glDepthFunc(GL_LESS);
+            glDepthMask(GL_TRUE);   // glClear skips depth while writes are masked
+        }
+    });
+
+    if (post) {
+        m_postProcess.addPasses(m_frameGraph, scene, sceneColor, renderWidth, renderHeight, output, width, height);
+    }
+    else if (scaled) {
+        FrameGraph::Builder upscalePass = m_frameGraph.addPass("Upscale");
+        upscalePass.read(sceneColor);
+        upscalePass.write(output);
+        upscalePass.setExecute([&]() {
+            PROFILE_SCOPE("Upscale");
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, m_frameGraph.target(sceneColor).fbo);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_frameGraph.target(output).fbo);
+            glBlitFramebuffer(0, 0, renderWidth, renderHeight, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+            glBindFramebuffer(GL_FRAMEBUFFER, m_frameGraph.target(output).fbo);
+        });
+    }
+
+    {
+        PROFILE_SCOPE("Frame graph");
+        m_frameGraph.compile();
+        m_frameGraph.execute(m_renderTargets);
+    }
+    // Passes clear their queues after submitting; this drops draws queued for culled passes.
+    m_shadowQueue.clear();
+    m_prepassQueue.clear();
+    m_renderQueue.clear();
+    m_renderTargets.endFrame();
+    m_frameTimer.end();
+
+    m_frameUniforms.endFrame();
+}
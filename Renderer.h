@@ -0,0 +1,195 @@
+#pragma once
+#include <GL/glew.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ClusteredLights.h"
+#include "Config.h"
+#include "DynamicResolution.h"
+#include "FileWatcher.h"
+#include "FrameGraph.h"
+#include "FragmentCounter.h"
+#include "FrustumCuller.h"
+#include "GpuTimer.h"
+#include "Mesh.h"
+#include "MeshLod.h"
+#include "OcclusionCuller.h"
+#include "PostProcess.h"
+#include "RenderQueue.h"
+#include "RenderTargetPool.h"
+#include "ResourceManager.h"
+#include "SceneSettings.h"
+#include "ShaderProgram.h"
+#include "ShaderVariants.h"
+#include "ShadowMap.h"
+#include "Simulation.h"
+#include "UniformRingBuffer.h"
+
+// Cost of recording the separate-draw stress scene's draw packets (last frame).
+struct DrawPacketStats
+{
+    double recordMs = 0.0;      // building every packet on the job system, wall clock
+    double mergeMs = 0.0;       // appending the per-thread lists to the render queues
+    size_t packets = 0;
+    int threads = 1;
+};
+
+// Owns the GPU resources for the demo scene and draws one frame of it from a
+// SceneSettings snapshot. Shared by the interactive window and headless runs.
+class Renderer
+{
+public:
+    Renderer() = default;
+    ~Renderer();
+    Renderer(const Renderer&) = delete;
+    Renderer& operator=(const Renderer&) = delete;
+
+    bool init(const Config& config);
+
+    // Renders into `targetFramebuffer` (0 = default framebuffer) with a width x height viewport.
+    // With scene.dynamicResolution the scene itself may be drawn smaller and upscaled.
+    // Animation comes from `state`; `scene` only says what is switched on.
+    void renderFrame(const SceneSettings& scene, const SimState& state, int width, int height, GLuint targetFramebuffer = 0);
+
+    // Watches shaders/ and recompiles edited programs in the background. `onChange` is
+    // called from the watcher thread (e.g. to wake an idle event loop).
+    bool enableShaderHotReload(std::function<void()> onChange);
+    // Starts reloads for changed files and swaps in finished ones; call once per frame.
+    void updateShaderReloads();
+    // True while changes are waiting or programs are compiling; frames must keep coming.
+    bool shaderReloadBusy() const;
+
+    // Loads (or reloads) the scene texture; returns false if it could not be read.
+    bool loadTexture();
+    bool hasTexture() const { return m_texture != nullptr; }
+    const std::string& texturePath() const { return m_texturePath; }
+
+    bool shadowMapReady() const { return m_shadowMapReady; }
+    const ShadowMap& shadowMap() const { return m_shadowMap; }
+    const UniformRingBuffer& frameUniforms() const { return m_frameUniforms; }
+    bool clusteredLightsReady() const { return m_clusteredReady; }
+    const ClusteredLights& clusteredLights() const { return m_clusteredLights; }
+    // Samples that passed the depth test in the shading pass, i.e. fragment shader runs
+    // (a few frames old). Divide by the pixel count for average overdraw.
+    uint64_t shadedFragments() const { return m_shadedFragments.samples(); }
+    const OcclusionCuller& occlusionCuller() const { return m_occlusionCuller; }
+    // Whether the last frame ran the occlusion culler; its timings are from an older frame otherwise.
+    bool occlusionRan() const { return m_occlusionRan; }
+    bool postProcessReady() const { return m_postReady; }
+    const RenderTargetPool& renderTargets() const { return m_renderTargets; }
+    // The last frame's compiled pass graph (see FrameGraph::dump).
+    const FrameGraph& frameGraph() const { return m_frameGraph; }
+    const DynamicResolution& dynamicResolution() const { return m_dynamicResolution; }
+    // Size the last frame's scene was drawn at, before upscaling.
+    int renderWidth() const { return m_renderWidth; }
+    int renderHeight() const { return m_renderHeight; }
+    const DrawPacketStats& drawPacketStats() const { return m_packetStats; }
+    // Camera-visible objects drawn at each detail level last frame, finest first; empty when
+    // the shape has no detail chain or LOD is off.
+    const std::vector<unsigned int>& lodCounts() const { return m_lodCounts; }
+
+private:
+    // Finest level for shapes with a detail chain; shapeLods() is null for the others.
+    Mesh* shapeMesh(ShapeType shape) const;
+    const MeshLod* shapeLods(ShapeType shape) const;
+    void updatePointLights(int count, float time, bool animate);
+
+    // Depth-only program for one feature mask plus its cached `cascade` handle.
+    struct DepthProgram {
+        ShaderProgram* program = nullptr;
+        ShaderProgram::Uniform cascade = -1;
+    };
+    DepthProgram& depthProgram(uint32_t features);
+
+    // Per-pass templates for the separate-draw scene; each object's copy gets its own model
+    // matrix, normal matrix and depth. A template without a shader records nothing.
+    struct PacketTemplates {
+        DrawItem surface;
+        DrawItem shadow;
+        DrawItem prepass;
+    };
+    // Records one packet per visible object and pass into per-thread DrawLists on the job
+    // system, then merges them into the render queues.
+    // With `lods`, each packet draws the level picked for its object in m_instanceLods.
+    void recordDrawPackets(const PacketTemplates& templates, const MeshLod* lods, const glm::mat4& sceneModel,
+        const glm::vec3& cameraPos);
+
+    ShaderVariants m_basicShaders;      // basic.vert + basic.frag
+    ShaderVariants m_depthShaders;      // shadow_depth.vert + shadow_depth.frag
+    ShaderVariants m_prepassShaders;    // depth_prepass.vert + shadow_depth.frag
+    ShaderVariants m_overdrawShaders;   // basic.vert + overdraw.frag
+    std::vector<ShaderVariants*> m_shaderSets;  // every set above plus the post-processing ones
+    DepthProgram m_depthPrograms[2];    // indexed by SHADER_INSTANCED != 0
+
+    FileWatcher m_shaderWatcher;
+
+    UniformRingBuffer m_frameUniforms;
+    ShadowMap m_shadowMap;
+    bool m_shadowMapReady = false;
+    float m_shadowDistance = 20.0f;
+
+    ClusteredLights m_clusteredLights;
+    bool m_clusteredReady = false;
+    std::vector<PointLight> m_pointLights;
+
+    // Draws are collected per frame and submitted sorted by state.
+    RenderQueue m_renderQueue;
+    RenderQueue m_shadowQueue;
+    RenderQueue m_prepassQueue;
+    FragmentCounter m_shadedFragments;
+
+    // Indexed by JobSystem::threadIndex(), so workers never share a list.
+    struct ThreadDrawLists {
+        DrawList surface;
+        DrawList shadow;
+        DrawList prepass;
+    };
+    std::vector<ThreadDrawLists> m_drawLists;
+    DrawPacketStats m_packetStats;
+
+    FrameGraph m_frameGraph;
+    GpuTimer m_frameTimer;
+    DynamicResolution m_dynamicResolution;
+    int m_renderWidth = 0;
+    int m_renderHeight = 0;
+    RenderTargetPool m_renderTargets;
+    PostProcess m_postProcess;
+    bool m_postReady = false;
+
+    ResourceManager m_resources;
+    std::shared_ptr<Texture> m_texture;
+    std::string m_texturePath;
+
+    Mesh* m_triangle = nullptr;
+    Mesh* m_rectangle = nullptr;
+    MeshLod* m_circleLods = nullptr;
+    Mesh* m_pyramid = nullptr;
+    MeshLod* m_sphereLods = nullptr;
+    Mesh* m_backdrop = nullptr;
+
+    // The shape's draws for the shading, pre-pass and shadow passes: one per detail level in
+    // use. Instanced draws take the first drawInstances of the mesh's instance buffer in the
+    // camera passes and all shadowInstances in the shadow pass; plain draws have both at 0.
+    struct ShapeDraw {
+        Mesh* mesh;
+        GLsizei drawInstances;
+        GLsizei shadowInstances;
+    };
+    std::vector<ShapeDraw> m_shapeDraws;
+    int m_shapeLod = 0;
+    std::vector<unsigned int> m_lodCounts;
+
+    // Instanced stress scene
+    int m_builtInstanceCount = -1;
+    const Mesh* m_builtInstanceMesh = nullptr;
+    std::vector<InstanceData> m_instances;
+    std::vector<InstanceData> m_visibleInstances;
+    FrustumCuller m_instanceCuller;     // instance bounds in the scene's model space
+    std::vector<BoxBounds> m_instanceBoxes;
+    std::vector<uint8_t> m_instanceMask;
+    std::vector<uint8_t> m_instanceLods;    // detail level per instance, kept for hysteresis
+    FrustumCuller m_sceneCuller;
+    OcclusionCuller m_occlusionCuller;
+    bool m_occlusionRan = false;
+};
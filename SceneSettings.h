@@ -0,0 +1,64 @@
+#pragma once
+#include <glm/glm.hpp>
+
+enum ShapeType { TRIANGLE, RECTANGLE, CIRCLE, PYRAMID, SPHERE };
+
+// Everything the UI (or a headless run) can change about what is drawn.
+struct SceneSettings
+{
+    bool is3DMode = false;
+    ShapeType shape = TRIANGLE;
+    bool useTexture = false;
+
+    int lightPreset = 0;    // index into the Top-Left / Bottom-Right / Front presets
+    bool animateLight = false;
+    glm::vec3 lightColor = glm::vec3(1.0f);
+    float lightIntensity = 5.0f;
+
+    bool toggleUpDown = false;
+    bool toggleLeftRight = false;
+    bool toggleSpin = false;
+    float animationSpeed = 1.0f;
+
+    // Instanced stress scene: N copies of the current shape in one draw call.
+    bool instancedScene = false;
+    int instanceCount = 1000;
+    // Draw the stress-scene objects one draw call each, with their draw packets recorded in
+    // parallel on the job system, instead of as one instanced call.
+    bool separateDraws = false;
+    // Circles and spheres draw the coarsest pre-built level whose error stays under
+    // lodPixelError pixels on screen.
+    bool meshLod = true;
+    float lodPixelError = 1.0f;
+    // Skip objects the CPU-rasterized backdrop hides (3D camera only).
+    bool occlusionCulling = true;
+
+    bool shadowsEnabled = true;
+    int shadowPcfRadius = 1;
+
+    // Clustered point lights orbiting the scene (3D mode only); they move with animateLight.
+    bool pointLights = false;
+    int pointLightCount = 256;
+
+    // Depth-only pass first, then shade with GL_EQUAL so each pixel runs the lighting shader once.
+    bool depthPrepass = false;
+    // Replace shading with an additive count of shaded fragments per pixel.
+    bool overdrawView = false;
+
+    // Post-processing: the scene renders to an HDR target first (see PostProcess). Off by
+    // default so scenes keep their look; turning it on applies the effects enabled below.
+    bool postProcess = false;
+    bool tonemap = true;
+    bool fxaa = true;
+    bool bloom = false;
+    float exposure = 1.0f;
+    float bloomThreshold = 1.0f;    // HDR brightness where bloom starts
+    float bloomIntensity = 0.1f;
+
+    // Render the scene below window resolution while the GPU misses its frame time budget
+    // (see DynamicResolution); the UI is always drawn at window resolution.
+    bool dynamicResolution = false;
+
+    // True when consecutive frames differ even without input.
+    bool isAnimating() const { return toggleUpDown || toggleLeftRight || toggleSpin || animateLight; }
+};
@@ -0,0 +1,150 @@
+#include "ShaderCache.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+const uint32_t kMagic = 0x42443353;    // "S3DB"
+const uint32_t kVersion = 1;
+const uint32_t kMaxBinaryLength = 64u << 20;  // far beyond any real program binary
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t length;
+};
+
+uint64_t fnv1a(uint64_t hash, const std::string& data)
+{
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    // Separator so ("ab", "c") and ("a", "bc") hash differently.
+    hash ^= 0xFF;
+    hash *= 1099511628211ull;
+    return hash;
+}
+}
+
+bool ShaderCache::init(const std::string& directory)
+{
+    m_enabled = false;
+    // The query is only valid with GL 4.1 or ARB_get_program_binary; on a plain 3.3 context it
+    // would raise GL_INVALID_ENUM.
+    GLint formats = 0;
+    if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats <= 0) {
+        std::cout << "Shader cache disabled: driver exposes no program binary formats\n";
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec) {
+        std::cerr << "Shader cache disabled: cannot create " << directory << ": " << ec.message() << "\n";
+        return false;
+    }
+
+    auto glString = [](GLenum name) {
+        const GLubyte* s = glGetString(name);
+        return s ? std::string(reinterpret_cast<const char*>(s)) : std::string();
+    };
+    m_driver = glString(GL_VENDOR) + "|" + glString(GL_RENDERER) + "|" + glString(GL_VERSION);
+    m_directory = directory;
+    m_enabled = true;
+    return true;
+}
+
+uint64_t ShaderCache::makeKey(const std::string& vertexSource, const std::string& fragmentSource, const std::string& defines) const
+{
+    uint64_t hash = 14695981039346656037ull;
+    hash = fnv1a(hash, m_driver);
+    hash = fnv1a(hash, defines);
+    hash = fnv1a(hash, vertexSource);
+    hash = fnv1a(hash, fragmentSource);
+    return hash;
+}
+
+std::string ShaderCache::pathFor(uint64_t key) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(m_directory) / name).string();
+}
+
+GLuint ShaderCache::load(uint64_t key)
+{
+    if (!m_enabled) return 0;
+
+    std::string path = pathFor(key);
+    std::ifstream file(path, std::ios::binary);
+    CacheHeader header = {};
+    if (!file || !file.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || header.magic != kMagic || header.version != kVersion || header.key != key) {
+        m_misses++;
+        return 0;
+    }
+    // The length comes from disk; a corrupt entry must not turn into a huge allocation.
+    std::error_code error;
+    const std::uintmax_t fileSize = std::filesystem::file_size(path, error);
+    if (error || header.length == 0 || header.length > kMaxBinaryLength
+        || header.length > fileSize - sizeof(header)) {
+        m_misses++;
+        return 0;
+    }
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), binary.size())) {
+        m_misses++;
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        // The driver rejected it (e.g. after an update); fall back to source and rewrite the entry.
+        glDeleteProgram(program);
+        file.close();
+        std::remove(path.c_str());
+        m_misses++;
+        return 0;
+    }
+    m_hits++;
+    return program;
+}
+
+void ShaderCache::store(uint64_t key, GLuint program)
+{
+    if (!m_enabled) return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0) return;
+
+    CacheHeader header = { kMagic, kVersion, key, format, static_cast<uint32_t>(written) };
+    // Write to a temporary name first so a crash never leaves a truncated entry behind.
+    std::string path = pathFor(key);
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary);
+        if (!file) return;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), written);
+        if (!file) return;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+}
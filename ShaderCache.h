@@ -0,0 +1,37 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstdint>
+#include <string>
+
+// On-disk cache of linked program binaries (glGetProgramBinary). Entries are keyed by
+// a hash of the shader sources, any defines and the driver's vendor/renderer/version
+// strings, so a driver update or an edited shader simply misses and recompiles.
+class ShaderCache
+{
+public:
+    // Enables the cache in `directory` if the driver supports program binaries.
+    // Needs a current GL context.
+    bool init(const std::string& directory);
+    bool enabled() const { return m_enabled; }
+
+    uint64_t makeKey(const std::string& vertexSource, const std::string& fragmentSource, const std::string& defines) const;
+
+    // Returns a linked program built from the cached binary, or 0 on a miss.
+    GLuint load(uint64_t key);
+    // Stores a program linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+    void store(uint64_t key, GLuint program);
+
+    unsigned int hits() const { return m_hits; }
+    unsigned int misses() const { return m_misses; }
+
+private:
+    std::string pathFor(uint64_t key) const;
+
+    bool m_enabled = false;
+    std::string m_directory;
+    std::string m_driver;
+    unsigned int m_hits = 0;
+    unsigned int m_misses = 0;
+};
+
+inline ShaderCache shaderCache;
@@ -0,0 +1,410 @@
+#include "ShaderProgram.h"
+#include "FrameStats.h"
+#include "ShaderCache.h"
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+std::string LoadShaderSource(const std::string& filepath) {
+    std::ifstream file(filepath);
+    if (!file) {
+        std::cerr << "Failed to load shader: " << filepath << std::endl;
+        return "";
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+static bool expandIncludes(const std::string& filepath, std::vector<std::string>& files, std::string& out)
+{
+    const int fileIndex = static_cast<int>(files.size());
+    files.push_back(filepath);
+    std::ifstream file(filepath);
+    if (!file) {
+        std::cerr << "Failed to load shader: " << filepath << std::endl;
+        return false;
+    }
+
+    // #line keeps compiler messages pointing at "<file index>:<line>" of the original file.
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line.compare(start, 8, "#include") != 0) {
+            out += line;
+            out += '\n';
+            continue;
+        }
+
+        size_t open = line.find('"', start + 8);
+        size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+        if (close == std::string::npos) {
+            std::cerr << filepath << ":" << lineNumber << ": malformed #include" << std::endl;
+            return false;
+        }
+        std::filesystem::path included = std::filesystem::path(filepath).parent_path() / line.substr(open + 1, close - open - 1);
+        std::string includedPath = included.lexically_normal().generic_string();
+        if (std::find(files.begin(), files.end(), includedPath) == files.end()) {
+            out += "#line 1 " + std::to_string(files.size()) + "\n";
+            if (!expandIncludes(includedPath, files, out)) return false;
+        }
+        out += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+    }
+    return true;
+}
+
+std::string PreprocessShaderSource(const std::string& filepath, const std::string& defines, std::vector<std::string>* files)
+{
+    std::vector<std::string> localFiles;
+    std::vector<std::string>& included = files ? *files : localFiles;
+    // Includes are tracked per stage so the #line file indices start at 0 for each one.
+    std::vector<std::string> stageFiles;
+    std::string source;
+    bool ok = expandIncludes(filepath, stageFiles, source);
+    for (const std::string& path : stageFiles) {
+        if (std::find(included.begin(), included.end(), path) == included.end()) included.push_back(path);
+    }
+    if (!ok) return "";
+    if (defines.empty()) return source;
+
+    // #version must stay the first statement, so the defines go right after it.
+    size_t insertAt = 0;
+    size_t version = source.find("#version");
+    if (version != std::string::npos) {
+        size_t end = source.find('\n', version);
+        insertAt = end == std::string::npos ? source.size() : end + 1;
+    }
+    std::string header = defines;
+    if (header.back() != '\n') header += '\n';
+    header += "#line " + std::to_string(std::count(source.begin(), source.begin() + insertAt, '\n') + 1) + " 0\n";
+    source.insert(insertAt, header);
+    return source;
+}
+
+GLuint CompileShader(GLenum type, const std::string& source) {
+    GLuint shader = glCreateShader(type);
+    const char* src = source.c_str();
+    glShaderSource(shader, 1, &src, nullptr);
+    glCompileShader(shader);
+
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        char infoLog[512];
+        glGetShaderInfoLog(shader, 512, nullptr, infoLog);
+        std::cerr << "Shader compile error:\n" << infoLog << std::endl;
+    }
+    return shader;
+}
+
+GLuint CreateShaderProgram(const std::string& vertexPath, const std::string& fragmentPath) {
+    return CreateShaderProgramFromSource(PreprocessShaderSource(vertexPath, ""), PreprocessShaderSource(fragmentPath, ""));
+}
+
+GLuint CreateShaderProgramFromSource(const std::string& vertexCode, const std::string& fragmentCode) {
+    GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, vertexCode);
+    GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentCode);
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    if (shaderCache.enabled())
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(program);
+
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return program;
+}
+
+// KHR and ARB parallel_shader_compile share enum values.
+static bool parallelCompileAvailable()
+{
+    static int available = -1;
+    if (available < 0) {
+        available = 0;
+        if (GLEW_KHR_parallel_shader_compile) {
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);     // let the driver decide
+            available = 1;
+        }
+        else if (GLEW_ARB_parallel_shader_compile) {
+            glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+            available = 1;
+        }
+    }
+    return available == 1;
+}
+
+ShaderProgram::~ShaderProgram()
+{
+    discardPending();
+    if (m_id) glDeleteProgram(m_id);
+}
+
+bool ShaderProgram::loadFromFiles(const std::string& vertexPath, const std::string& fragmentPath, const std::string& defines)
+{
+    m_vertexPath = vertexPath;
+    m_fragmentPath = fragmentPath;
+    m_defines = defines;
+    m_sourceFiles.clear();
+    std::string vertexCode = PreprocessShaderSource(vertexPath, defines, &m_sourceFiles);
+    std::string fragmentCode = PreprocessShaderSource(fragmentPath, defines, &m_sourceFiles);
+    if (vertexCode.empty() || fragmentCode.empty()) return false;
+
+    const uint64_t cacheKey = shaderCache.makeKey(vertexCode, fragmentCode, defines);
+    GLuint program = shaderCache.load(cacheKey);
+    if (!program) {
+        program = CreateShaderProgramFromSource(vertexCode, fragmentCode);
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            char infoLog[512];
+            glGetProgramInfoLog(program, 512, nullptr, infoLog);
+            std::cerr << "Shader link error (" << vertexPath << ", " << fragmentPath << "):\n" << infoLog << std::endl;
+            glDeleteProgram(program);
+            return false;
+        }
+        shaderCache.store(cacheKey, program);
+    }
+
+    adopt(program);
+    return true;
+}
+
+bool ShaderProgram::beginReload()
+{
+    discardPending();
+    // Includes may have been added or removed since the last build.
+    std::vector<std::string> files;
+    std::string vertexCode = PreprocessShaderSource(m_vertexPath, m_defines, &files);
+    std::string fragmentCode = PreprocessShaderSource(m_fragmentPath, m_defines, &files);
+    m_sourceFiles = files;
+    if (vertexCode.empty() || fragmentCode.empty()) return false;
+
+    m_pendingCacheKey = shaderCache.makeKey(vertexCode, fragmentCode, m_defines);
+    m_pendingPolls = 0;
+    if (GLuint cached = shaderCache.load(m_pendingCacheKey)) {
+        m_pending = cached;
+        return true;
+    }
+
+    // Same steps as CreateShaderProgramFromSource, minus every status query: with parallel
+    // compile those are what would block.
+    const char* vertexSrc = vertexCode.c_str();
+    const char* fragmentSrc = fragmentCode.c_str();
+    m_pendingShaders[0] = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(m_pendingShaders[0], 1, &vertexSrc, nullptr);
+    glCompileShader(m_pendingShaders[0]);
+    m_pendingShaders[1] = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(m_pendingShaders[1], 1, &fragmentSrc, nullptr);
+    glCompileShader(m_pendingShaders[1]);
+
+    m_pending = glCreateProgram();
+    glAttachShader(m_pending, m_pendingShaders[0]);
+    glAttachShader(m_pending, m_pendingShaders[1]);
+    if (shaderCache.enabled())
+        glProgramParameteri(m_pending, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(m_pending);
+    return true;
+}
+
+ShaderProgram::ReloadStatus ShaderProgram::pollReload()
+{
+    if (!m_pending) return ReloadStatus::Idle;
+
+    if (parallelCompileAvailable()) {
+        GLint done = GL_FALSE;
+        glGetProgramiv(m_pending, GL_COMPLETION_STATUS_KHR, &done);
+        if (!done) return ReloadStatus::Pending;
+    }
+    else if (m_pendingPolls++ < 1) {
+        // Without the extension the status query blocks; give threaded drivers a frame first.
+        return ReloadStatus::Pending;
+    }
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(m_pending, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        char infoLog[512];
+        for (GLuint shader : m_pendingShaders) {
+            GLint compiled = GL_TRUE;
+            if (shader) glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+            if (!compiled) {
+                glGetShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
+                std::cerr << "Shader compile error:\n" << infoLog << std::endl;
+            }
+        }
+        glGetProgramInfoLog(m_pending, sizeof(infoLog), nullptr, infoLog);
+        std::cerr << "Reload of " << m_vertexPath << " + " << m_fragmentPath << " failed, keeping the previous program\n"
+                  << infoLog << std::endl;
+        discardPending();
+        return ReloadStatus::Failed;
+    }
+
+    GLuint program = m_pending;
+    m_pending = 0;
+    if (m_pendingShaders[0]) shaderCache.store(m_pendingCacheKey, program);
+    discardPending();
+    adopt(program);
+    return ReloadStatus::Reloaded;
+}
+
+void ShaderProgram::discardPending()
+{
+    for (GLuint& shader : m_pendingShaders) {
+        if (shader) glDeleteShader(shader);
+        shader = 0;
+    }
+    if (m_pending) glDeleteProgram(m_pending);
+    m_pending = 0;
+}
+
+void ShaderProgram::adopt(GLuint program)
+{
+    if (m_id) glDeleteProgram(m_id);
+    m_id = program;
+    reflect();
+    for (const auto& block : m_blockBindings) {
+        GLuint index = glGetUniformBlockIndex(m_id, block.first.c_str());
+        if (index != GL_INVALID_INDEX) glUniformBlockBinding(m_id, index, block.second);
+    }
+    if (!m_samplerBindings.empty()) glUseProgram(m_id);
+    for (const auto& sampler : m_samplerBindings) {
+        GLint location = glGetUniformLocation(m_id, sampler.first.c_str());
+        if (location >= 0) glUniform1i(location, sampler.second);
+    }
+}
+
+void ShaderProgram::reflect()
+{
+    // Handles are indices into m_uniforms, so on a reload existing names keep their slot
+    // (with location -1 if the uniform went away) and new names are appended.
+    for (UniformInfo& info : m_uniforms) info.location = -1;
+
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(m_id, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(m_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::vector<char> nameBuf(maxLength > 0 ? maxLength : 1);
+    for (GLint i = 0; i < count; ++i) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(m_id, static_cast<GLuint>(i), maxLength, &length, &size, &type, nameBuf.data());
+
+        std::string name(nameBuf.data(), length);
+        // Arrays are reported as "name[0]"; expose them under the bare name.
+        if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+            name.resize(name.size() - 3);
+
+        // Members of uniform blocks have no location and are not settable here.
+        GLint location = glGetUniformLocation(m_id, nameBuf.data());
+        if (location < 0) continue;
+
+        auto existing = std::find_if(m_uniforms.begin(), m_uniforms.end(),
+            [&](const UniformInfo& info) { return info.name == name; });
+        if (existing != m_uniforms.end()) *existing = { name, location, type, size };
+        else m_uniforms.push_back({ name, location, type, size });
+    }
+}
+
+void ShaderProgram::use() const
+{
+    glUseProgram(m_id);
+    frameStats.glCalls++;
+}
+
+ShaderProgram::Uniform ShaderProgram::uniform(const std::string& name) const
+{
+    frameStats.uniformLookups++;
+    for (size_t i = 0; i < m_uniforms.size(); ++i) {
+        if (m_uniforms[i].name == name) return static_cast<Uniform>(i);
+    }
+    m_uniforms.push_back({ name, -1, 0, 0 });
+    return static_cast<Uniform>(m_uniforms.size() - 1);
+}
+
+bool ShaderProgram::bindUniformBlock(const std::string& blockName, GLuint bindingPoint)
+{
+    bool known = false;
+    for (auto& block : m_blockBindings) {
+        if (block.first == blockName) {
+            block.second = bindingPoint;
+            known = true;
+        }
+    }
+    if (!known) m_blockBindings.emplace_back(blockName, bindingPoint);
+
+    GLuint index = glGetUniformBlockIndex(m_id, blockName.c_str());
+    if (index == GL_INVALID_INDEX) return false;
+    glUniformBlockBinding(m_id, index, bindingPoint);
+    return true;
+}
+
+bool ShaderProgram::bindSampler(const std::string& name, GLint unit)
+{
+    auto known = std::find_if(m_samplerBindings.begin(), m_samplerBindings.end(),
+        [&](const std::pair<std::string, GLint>& sampler) { return sampler.first == name; });
+    if (known != m_samplerBindings.end()) known->second = unit;
+    else m_samplerBindings.emplace_back(name, unit);
+
+    GLint location = glGetUniformLocation(m_id, name.c_str());
+    if (location < 0) return false;
+    glUseProgram(m_id);
+    glUniform1i(location, unit);
+    return true;
+}
+
+void ShaderProgram::setInt(Uniform u, int value) const
+{
+    if (u < 0 || m_uniforms[u].location < 0) return;
+    glUniform1i(m_uniforms[u].location, value);
+    frameStats.glCalls++;
+    frameStats.uniformUploads++;
+}
+
+void ShaderProgram::setFloat(Uniform u, float value) const
+{
+    if (u < 0 || m_uniforms[u].location < 0) return;
+    glUniform1f(m_uniforms[u].location, value);
+    frameStats.glCalls++;
+    frameStats.uniformUploads++;
+}
+
+void ShaderProgram::setVec2(Uniform u, const glm::vec2& value) const
+{
+    if (u < 0 || m_uniforms[u].location < 0) return;
+    glUniform2fv(m_uniforms[u].location, 1, glm::value_ptr(value));
+    frameStats.glCalls++;
+    frameStats.uniformUploads++;
+}
+
+void ShaderProgram::setVec3(Uniform u, const glm::vec3& value) const
+{
+    if (u < 0 || m_uniforms[u].location < 0) return;
+    glUniform3fv(m_uniforms[u].location, 1, glm::value_ptr(value));
+    frameStats.glCalls++;
+    frameStats.uniformUploads++;
+}
+
+void ShaderProgram::setMat3(Uniform u, const glm::mat3& value) const
+{
+    if (u < 0 || m_uniforms[u].location < 0) return;
+    glUniformMatrix3fv(m_uniforms[u].location, 1, GL_FALSE, glm::value_ptr(value));
+    frameStats.glCalls++;
+    frameStats.uniformUploads++;
+}
+
+void ShaderProgram::setMat4(Uniform u, const glm::mat4& value) const
+{
+    if (u < 0 || m_uniforms[u].location < 0) return;
+    glUniformMatrix4fv(m_uniforms[u].location, 1, GL_FALSE, glm::value_ptr(value));
+    frameStats.glCalls++;
+    frameStats.uniformUploads++;
+}
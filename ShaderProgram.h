@@ -0,0 +1,94 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+std::string LoadShaderSource(const std::string& filepath);
+// LoadShaderSource plus two source transforms: `#include "file"` is expanded (relative to the
+// including file, each file at most once) and `defines` is inserted after the #version line.
+// Every file read is appended to `files` when given.
+std::string PreprocessShaderSource(const std::string& filepath, const std::string& defines,
+    std::vector<std::string>* files = nullptr);
+GLuint CompileShader(GLenum type, const std::string& source);
+GLuint CreateShaderProgram(const std::string& vertexPath, const std::string& fragmentPath);
+GLuint CreateShaderProgramFromSource(const std::string& vertexCode, const std::string& fragmentCode);
+
+class ShaderProgram
+{
+public:
+    // Index into the uniform table reflected at link time. Stays valid across reloads; setting
+    // it is a no-op while the uniform is not active.
+    using Uniform = int;
+
+    ShaderProgram() = default;
+    ~ShaderProgram();
+    ShaderProgram(const ShaderProgram&) = delete;
+    ShaderProgram& operator=(const ShaderProgram&) = delete;
+
+    enum class ReloadStatus { Idle, Pending, Reloaded, Failed };
+
+    // `defines` is a block of #define lines injected into both stages (see PreprocessShaderSource).
+    bool loadFromFiles(const std::string& vertexPath, const std::string& fragmentPath, const std::string& defines = "");
+    void use() const;
+    GLuint id() const { return m_id; }
+    const std::string& vertexPath() const { return m_vertexPath; }
+    const std::string& fragmentPath() const { return m_fragmentPath; }
+    // Both stages plus everything they #include.
+    const std::vector<std::string>& sourceFiles() const { return m_sourceFiles; }
+
+    // Re-reads both files and starts compiling them in the background (with
+    // KHR/ARB_parallel_shader_compile where available). The current program stays in use.
+    bool beginReload();
+    // Call once per frame while a reload is pending. Never blocks on the compiler when
+    // parallel compile is available. On success the new program replaces the old one;
+    // existing Uniform handles keep referring to the same names.
+    ReloadStatus pollReload();
+    bool reloadPending() const { return m_pending != 0; }
+
+    // Resolves a name against the reflected table. Names the program does not declare are
+    // registered with no location, so a reload that adds them makes the handle live. Searches
+    // by name: call at setup or once per program bind, not per draw.
+    Uniform uniform(const std::string& name) const;
+
+    // Attaches a uniform block to a buffer binding point. Returns false if the block is not active.
+    // The binding is re-applied after a reload.
+    bool bindUniformBlock(const std::string& blockName, GLuint bindingPoint);
+    // Points a sampler at a fixed texture unit (leaves this program bound). Returns false if the
+    // sampler is not active. Also re-applied after a reload.
+    bool bindSampler(const std::string& name, GLint unit);
+
+    void setInt(Uniform u, int value) const;
+    void setFloat(Uniform u, float value) const;
+    void setVec2(Uniform u, const glm::vec2& value) const;
+    void setVec3(Uniform u, const glm::vec3& value) const;
+    void setMat3(Uniform u, const glm::mat3& value) const;
+    void setMat4(Uniform u, const glm::mat4& value) const;
+
+private:
+    struct UniformInfo {
+        std::string name;
+        GLint location;
+        GLenum type;
+        GLint size;
+    };
+
+    GLuint m_id = 0;
+    mutable std::vector<UniformInfo> m_uniforms;  // uniform() appends unknown names
+    std::vector<std::pair<std::string, GLuint>> m_blockBindings;
+    std::vector<std::pair<std::string, GLint>> m_samplerBindings;
+    std::string m_vertexPath;
+    std::string m_fragmentPath;
+    std::string m_defines;
+    std::vector<std::string> m_sourceFiles;
+
+    // In-flight reload
+    GLuint m_pending = 0;
+    GLuint m_pendingShaders[2] = {};
+    uint64_t m_pendingCacheKey = 0;
+    int m_pendingPolls = 0;
+
+    void reflect();
+    void adopt(GLuint program);
+    void discardPending();
+};
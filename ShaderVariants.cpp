@@ -0,0 +1,120 @@
+#include "ShaderVariants.h"
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+static const char* const kFeatureNames[] = { "SHADOW", "TEXTURED", "INSTANCED", "CLUSTERED", "TONEMAP", "BLOOM", "PREFILTER" };
+static const uint32_t kFeatureCount = sizeof(kFeatureNames) / sizeof(kFeatureNames[0]);
+
+std::string ShaderVariants::definesFor(uint32_t features)
+{
+    std::string defines;
+    for (uint32_t bit = 0; bit < kFeatureCount; ++bit) {
+        if (features & (1u << bit)) defines += std::string("#define ") + kFeatureNames[bit] + "\n";
+    }
+    return defines;
+}
+
+std::string ShaderVariants::describe(uint32_t features)
+{
+    std::string text;
+    for (uint32_t bit = 0; bit < kFeatureCount; ++bit) {
+        if (!(features & (1u << bit))) continue;
+        if (!text.empty()) text += '|';
+        text += kFeatureNames[bit];
+    }
+    return text.empty() ? "base" : text;
+}
+
+void ShaderVariants::init(const std::string& vertexPath, const std::string& fragmentPath)
+{
+    m_vertexPath = vertexPath;
+    m_fragmentPath = fragmentPath;
+    m_variants.clear();
+}
+
+void ShaderVariants::bindUniformBlock(const std::string& blockName, GLuint bindingPoint)
+{
+    m_blockBindings.emplace_back(blockName, bindingPoint);
+    for (auto& variant : m_variants) {
+        if (variant.second) variant.second->bindUniformBlock(blockName, bindingPoint);
+    }
+}
+
+void ShaderVariants::bindSampler(const std::string& name, GLint unit)
+{
+    m_samplerBindings.emplace_back(name, unit);
+    for (auto& variant : m_variants) {
+        if (variant.second) variant.second->bindSampler(name, unit);
+    }
+}
+
+ShaderProgram* ShaderVariants::get(uint32_t features)
+{
+    auto it = m_variants.find(features);
+    if (it != m_variants.end()) return it->second.get();
+
+    auto start = std::chrono::steady_clock::now();
+    auto program = std::make_unique<ShaderProgram>();
+    if (!program->loadFromFiles(m_vertexPath, m_fragmentPath, definesFor(features))) {
+        std::cerr << "Failed to build shader " << m_vertexPath << " + " << m_fragmentPath
+                  << " [" << describe(features) << "]\n";
+        m_variants.emplace(features, nullptr);
+        return nullptr;
+    }
+    for (const auto& block : m_blockBindings)
+        program->bindUniformBlock(block.first, block.second);
+    for (const auto& sampler : m_samplerBindings)
+        program->bindSampler(sampler.first, sampler.second);
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Built " << m_vertexPath << " + " << m_fragmentPath << " [" << describe(features) << "] in "
+              << ms << " ms\n";
+    return m_variants.emplace(features, std::move(program)).first->second.get();
+}
+
+bool ShaderVariants::usesFile(const std::string& fileName) const
+{
+    auto matches = [&](const std::string& path) {
+        return std::filesystem::path(path).filename().string() == fileName;
+    };
+    if (matches(m_vertexPath) || matches(m_fragmentPath)) return true;
+    for (const auto& variant : m_variants) {
+        if (!variant.second) continue;
+        for (const std::string& path : variant.second->sourceFiles()) {
+            if (matches(path)) return true;
+        }
+    }
+    return false;
+}
+
+void ShaderVariants::beginReload()
+{
+    for (auto it = m_variants.begin(); it != m_variants.end();) {
+        // Let failed variants try again on the next get().
+        if (!it->second) {
+            it = m_variants.erase(it);
+            continue;
+        }
+        std::cout << "Reloading " << m_vertexPath << " + " << m_fragmentPath << " [" << describe(it->first) << "]\n";
+        it->second->beginReload();
+        ++it;
+    }
+}
+
+void ShaderVariants::pollReloads()
+{
+    for (auto& variant : m_variants) {
+        if (!variant.second || !variant.second->reloadPending()) continue;
+        if (variant.second->pollReload() == ShaderProgram::ReloadStatus::Reloaded)
+            std::cout << "Reloaded " << m_vertexPath << " + " << m_fragmentPath << " [" << describe(variant.first) << "]\n";
+    }
+}
+
+bool ShaderVariants::reloadPending() const
+{
+    for (const auto& variant : m_variants) {
+        if (variant.second && variant.second->reloadPending()) return true;
+    }
+    return false;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "ShaderProgram.h"
+
+// Compile-time shader features. Each bit becomes a #define of the same name in the
+// variant's source, so unused paths are compiled out instead of branched over per pixel.
+enum ShaderFeature : uint32_t {
+    SHADER_SHADOW    = 1u << 0,
+    SHADER_TEXTURED  = 1u << 1,
+    SHADER_INSTANCED = 1u << 2,
+    SHADER_CLUSTERED = 1u << 3,
+    // Post-processing (see PostProcess)
+    SHADER_TONEMAP   = 1u << 4,
+    SHADER_BLOOM     = 1u << 5,
+    SHADER_PREFILTER = 1u << 6,
+};
+
+// All permutations of one vertex/fragment pair, keyed by ShaderFeature bitmask. A
+// variant is compiled the first time it is requested (through the binary cache) and
+// kept for the lifetime of the set.
+class ShaderVariants
+{
+public:
+    void init(const std::string& vertexPath, const std::string& fragmentPath);
+
+    // Applied to every variant, including ones compiled later.
+    void bindUniformBlock(const std::string& blockName, GLuint bindingPoint);
+    void bindSampler(const std::string& name, GLint unit);
+
+    // Returns the program for `features`, compiling it if needed; nullptr if it failed to build.
+    // Failed variants are not retried until the sources change.
+    ShaderProgram* get(uint32_t features);
+    size_t compiledCount() const { return m_variants.size(); }
+
+    // True if any compiled variant reads `fileName` (compared by file name, not path).
+    bool usesFile(const std::string& fileName) const;
+    // Hot reload for every compiled variant; see ShaderProgram::beginReload/pollReload.
+    void beginReload();
+    void pollReloads();
+    bool reloadPending() const;
+
+    static std::string definesFor(uint32_t features);
+    static std::string describe(uint32_t features);
+
+private:
+    std::string m_vertexPath;
+    std::string m_fragmentPath;
+    std::vector<std::pair<std::string, GLuint>> m_blockBindings;
+    std::vector<std::pair<std::string, GLint>> m_samplerBindings;
+    // nullptr marks a variant that failed to build.
+    std::unordered_map<uint32_t, std::unique_ptr<ShaderProgram>> m_variants;
+};
@@ -0,0 +1,138 @@
+#include "ShadowMap.h"
+#include "FrameStats.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// How far behind a cascade (towards the light) casters are still captured.
+static const float kCasterPad = 10.0f;
+// Blend between logarithmic (1) and uniform (0) cascade splits.
+static const float kSplitLambda = 0.75f;
+
+ShadowMap::~ShadowMap()
+{
+    if (m_fbo) glDeleteFramebuffers(1, &m_fbo);
+    if (m_depthTex) glDeleteTextures(1, &m_depthTex);
+}
+
+bool ShadowMap::init(int resolution, int cascades)
+{
+    m_resolution = std::clamp(resolution, 256, 8192);
+    m_cascades = std::clamp(cascades, 1, kMaxCascades);
+    m_activeCascades = m_cascades;
+
+    glGenTextures(1, &m_depthTex);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_depthTex);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, m_resolution, m_resolution, m_cascades,
+        0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    // Linear filtering with compare mode gives a hardware 2x2 PCF tap per lookup.
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    const float border[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, border);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    glGenFramebuffers(1, &m_fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_depthTex, 0, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Shadow map framebuffer incomplete: 0x" << std::hex << status << std::dec << "\n";
+        return false;
+    }
+    return true;
+}
+
+void ShadowMap::update(const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane,
+    float shadowDistance, bool perspective, const glm::vec3& lightDir)
+{
+    // World-space corners of the full camera frustum.
+    const glm::mat4 invViewProj = glm::inverse(projection * view);
+    const glm::vec2 ndc[4] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } };
+    glm::vec3 nearCorners[4], farCorners[4];
+    for (int i = 0; i < 4; ++i) {
+        glm::vec4 n = invViewProj * glm::vec4(ndc[i].x, ndc[i].y, -1.0f, 1.0f);
+        glm::vec4 f = invViewProj * glm::vec4(ndc[i].x, ndc[i].y, 1.0f, 1.0f);
+        nearCorners[i] = glm::vec3(n) / n.w;
+        farCorners[i] = glm::vec3(f) / f.w;
+    }
+
+    m_activeCascades = perspective ? m_cascades : 1;
+    const float farLimit = perspective ? std::min(farPlane, shadowDistance) : farPlane;
+    const glm::vec3 L = glm::normalize(lightDir);
+    const glm::vec3 up = std::fabs(L.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+    float prevSplit = nearPlane;
+    for (int c = 0; c < m_activeCascades; ++c) {
+        float t0 = 0.0f, t1 = 1.0f;
+        float split = 1e9f; // orthographic: one cascade covers every fragment
+        if (perspective) {
+            float p = static_cast<float>(c + 1) / m_activeCascades;
+            float logSplit = nearPlane * std::pow(farLimit / nearPlane, p);
+            float uniformSplit = nearPlane + (farLimit - nearPlane) * p;
+            split = kSplitLambda * logSplit + (1.0f - kSplitLambda) * uniformSplit;
+            // View depth is linear along the frustum edges, so slice them by depth ratio.
+            t0 = (prevSplit - nearPlane) / (farPlane - nearPlane);
+            t1 = (split - nearPlane) / (farPlane - nearPlane);
+        }
+
+        glm::vec3 corners[8];
+        glm::vec3 center(0.0f);
+        for (int i = 0; i < 4; ++i) {
+            corners[i] = glm::mix(nearCorners[i], farCorners[i], t0);
+            corners[i + 4] = glm::mix(nearCorners[i], farCorners[i], t1);
+            center += corners[i] + corners[i + 4];
+        }
+        center /= 8.0f;
+
+        // A bounding sphere keeps the projection size constant as the camera rotates.
+        float radius = 0.0f;
+        for (const glm::vec3& corner : corners)
+            radius = std::max(radius, glm::length(corner - center));
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+
+        glm::mat4 lightView = glm::lookAt(center + L * (radius + kCasterPad), center, up);
+        glm::mat4 lightProj = glm::ortho(-radius, radius, -radius, radius, 0.0f, 2.0f * radius + kCasterPad);
+
+        // Snap the origin to whole shadow-map texels to stop edges shimmering when the camera moves.
+        glm::vec4 origin = lightProj * lightView * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        float halfRes = m_resolution * 0.5f;
+        lightProj[3][0] += (std::round(origin.x * halfRes) - origin.x * halfRes) / halfRes;
+        lightProj[3][1] += (std::round(origin.y * halfRes) - origin.y * halfRes) / halfRes;
+
+        m_lightSpace[c] = lightProj * lightView;
+        m_splits[c] = split;
+        prevSplit = split;
+    }
+}
+
+void ShadowMap::beginCascade(int index) const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_depthTex, 0, index);
+    glViewport(0, 0, m_resolution, m_resolution);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    frameStats.glCalls += 4;
+}
+
+void ShadowMap::end() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    frameStats.glCalls++;
+}
+
+void ShadowMap::bindTexture(GLenum unit) const
+{
+    glActiveTexture(unit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_depthTex);
+    frameStats.glCalls += 2;
+}
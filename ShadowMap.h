@@ -0,0 +1,44 @@
+#pragma once
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Depth-only shadow map for the directional light, stored as a 2D texture array
+// with one layer per cascade. Cascades split the camera frustum along view depth
+// and each gets its own light-space orthographic projection.
+class ShadowMap
+{
+public:
+    static constexpr int kMaxCascades = 4;
+
+    ShadowMap() = default;
+    ~ShadowMap();
+    ShadowMap(const ShadowMap&) = delete;
+    ShadowMap& operator=(const ShadowMap&) = delete;
+
+    bool init(int resolution, int cascades);
+
+    // Fits the cascades to the camera frustum. `shadowDistance` caps how far from the camera
+    // shadows are rendered; an orthographic camera always uses a single cascade.
+    void update(const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane,
+        float shadowDistance, bool perspective, const glm::vec3& lightDir);
+
+    // Binds the layer for cascade `index` as the depth target and clears it.
+    void beginCascade(int index) const;
+    void end() const;
+
+    void bindTexture(GLenum unit) const;
+
+    int resolution() const { return m_resolution; }
+    int cascades() const { return m_activeCascades; }
+    const glm::mat4& lightSpace(int index) const { return m_lightSpace[index]; }
+    float splitDepth(int index) const { return m_splits[index]; }
+
+private:
+    GLuint m_fbo = 0;
+    GLuint m_depthTex = 0;
+    int m_resolution = 0;
+    int m_cascades = 0;
+    int m_activeCascades = 0;
+    glm::mat4 m_lightSpace[kMaxCascades];
+    float m_splits[kMaxCascades] = {};
+};
@@ -0,0 +1,203 @@
+#include "Simulation.h"
+#include <algorithm>
+#include <cmath>
+
+Simulation::~Simulation()
+{
+    stop();
+}
+
+void Simulation::start(int rateHz)
+{
+    stop();
+    setRate(rateHz);
+    m_quit = false;
+    m_thread = std::thread(&Simulation::threadMain, this);
+}
+
+void Simulation::stop()
+{
+    m_quit = true;
+    wake();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void Simulation::setRate(int rateHz)
+{
+    m_timeStep.setRate(rateHz);
+    m_rate = m_timeStep.rate();
+}
+
+void Simulation::setInputs(const SceneSettings& scene)
+{
+    Inputs inputs;
+    inputs.upDown = scene.toggleUpDown;
+    inputs.leftRight = scene.toggleLeftRight;
+    inputs.spin = scene.toggleSpin;
+    inputs.animateLight = scene.animateLight;
+    inputs.speed = scene.animationSpeed;
+    if (m_inputsSent && inputs == m_sentInputs) return;
+    m_sentInputs = inputs;
+    m_inputsSent = true;
+
+    m_inputs.writeSlot() = inputs;
+    m_inputs.publish();
+    wake();
+}
+
+void Simulation::wake()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_wakeups++;
+    }
+    m_wake.notify_one();
+}
+
+unsigned int Simulation::wakeups()
+{
+    std::lock_guard<std::mutex> lock(m_wakeMutex);
+    return m_wakeups;
+}
+
+bool Simulation::idle()
+{
+    if (m_timeStep.paused() || m_timeStep.timeScale() <= 0.0) return true;
+    m_inputs.update();
+    return !m_inputs.read().animating();
+}
+
+glm::vec3 Simulation::objectOffset(const Inputs& inputs, float phase)
+{
+    // A sine bob plus a second sine/cosine motion on top; both axes follow the same phase.
+    glm::vec3 offset(0.0f);
+    glm::vec3 move(0.0f);
+    if (inputs.upDown) {
+        offset.y += sin(phase) * 0.5f;
+        move.y = sin(phase) * 0.5f;
+    }
+    if (inputs.leftRight) {
+        offset.x += sin(phase) * 0.5f;
+        move.x = cos(phase) * 0.5f;
+    }
+    return offset + move;
+}
+
+SimState Simulation::blend(const SimState& a, const SimState& b, float alpha)
+{
+    SimState state;
+    state.time = a.time + (b.time - a.time) * alpha;
+    state.objectOffset = glm::mix(a.objectOffset, b.objectOffset, alpha);
+    state.spinAngle = a.spinAngle + (b.spinAngle - a.spinAngle) * alpha;
+    state.lightAngle = a.lightAngle + (b.lightAngle - a.lightAngle) * alpha;
+    return state;
+}
+
+bool Simulation::applyControls()
+{
+    const double scale = m_timeScale.load();
+    const bool paused = m_paused.load();
+    const bool changed = scale != m_timeStep.timeScale() || paused != m_timeStep.paused();
+    m_timeStep.setTimeScale(scale);
+    m_timeStep.setPaused(paused);
+    const unsigned int requests = m_stepRequests.load();
+    if (requests != m_stepRequestsSeen) {
+        m_stepRequestsSeen = requests;
+        m_timeStep.requestStep();
+    }
+    return changed;
+}
+
+void Simulation::derive(const Inputs& inputs)
+{
+    m_state.time = static_cast<float>(m_timeStep.time());
+    m_state.objectOffset = objectOffset(inputs, static_cast<float>(m_phase));
+    m_state.spinAngle = static_cast<float>(m_spin);
+    m_state.lightAngle = static_cast<float>(m_light);
+}
+
+void Simulation::runSteps(int steps)
+{
+    Clock::time_point start = Clock::now();
+    m_inputs.update();
+    const Inputs& inputs = m_inputs.read();
+    if (!m_initialized) {
+        derive(inputs);
+        m_previous = m_state;
+        m_initialized = true;
+    }
+
+    // Spin and the light only advance while switched on, so they resume where they stopped.
+    const double dt = m_timeStep.stepSeconds();
+    for (int i = 0; i < steps; ++i) {
+        m_previous = m_state;
+        m_phase += inputs.speed * dt;
+        if (inputs.spin) m_spin += inputs.speed * dt;
+        if (inputs.animateLight) m_light += dt;
+        derive(inputs);
+    }
+
+    Snapshot& snapshot = m_snapshots.writeSlot();
+    snapshot.previous = m_previous;
+    snapshot.current = m_state;
+    snapshot.alpha = m_timeStep.alpha();
+    snapshot.alphaPerSecond = m_timeStep.paused() ? 0.0 : m_timeStep.timeScale() / dt;
+    snapshot.stepRequests = m_stepRequestsSeen;
+    snapshot.publishedAt = Clock::now();
+    m_snapshots.publish();
+
+    m_steps = m_timeStep.steps();
+    m_dropped = m_timeStep.droppedSteps();
+    if (steps > 0)
+        m_stepMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / steps;
+}
+
+SimState Simulation::advance(double realSeconds)
+{
+    applyControls();
+    runSteps(m_timeStep.advance(realSeconds));
+    m_alpha = static_cast<float>(m_timeStep.alpha());
+    return blend(m_previous, m_state, m_alpha);
+}
+
+void Simulation::threadMain()
+{
+    WallClock clock;
+    while (!m_quit.load(std::memory_order_acquire)) {
+        // Read first, so a wake() during the steps below is not missed by the wait.
+        const unsigned int seen = wakeups();
+
+        // Time since the last wake-up still runs under the old controls, so pausing keeps what
+        // was already shown. A pause or scale change republishes, so sample() stops (or
+        // retimes) its blend right away; advance(0) then picks up a single-step request.
+        int steps = m_timeStep.advance(clock.tick());
+        const bool changed = applyControls();
+        steps += m_timeStep.advance(0.0);
+        if (steps > 0 || changed || !m_initialized) runSteps(steps);
+
+        // Until the next step is due, or with nothing to step (paused, or no animation switched
+        // on) until wake(); the time spent idle is not simulated.
+        const bool idleNow = idle();
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        auto woken = [&] { return m_wakeups != seen || m_quit.load(); };
+        if (idleNow) {
+            m_wake.wait(lock, woken);
+            lock.unlock();
+            clock.tick();
+        }
+        else {
+            m_wake.wait_for(lock, std::chrono::duration<double>(m_timeStep.secondsUntilStep()), woken);
+        }
+    }
+}
+
+SimState Simulation::sample()
+{
+    m_snapshots.update();
+    const Snapshot& snapshot = m_snapshots.read();
+    const double since = std::chrono::duration<double>(Clock::now() - snapshot.publishedAt).count();
+    m_alpha = static_cast<float>(std::clamp(snapshot.alpha + since * snapshot.alphaPerSecond, 0.0, 1.0));
+    m_blending = snapshot.alphaPerSecond > 0.0 && m_alpha < 1.0f;
+    m_stepRequestsSampled = snapshot.stepRequests;
+    return blend(snapshot.previous, snapshot.current, m_alpha);
+}
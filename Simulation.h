@@ -0,0 +1,140 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "SceneSettings.h"
+#include "TimeStep.h"
+#include "TripleBuffer.h"
+
+// Animated part of the scene at one point in time; what the renderer draws from.
+struct SimState
+{
+    float time = 0.0f;                          // simulated seconds
+    glm::vec3 objectOffset = glm::vec3(0.0f);   // up/down and left/right motion of the shape
+    float spinAngle = 0.0f;                     // radians about the shape's spin axis
+    float lightAngle = 0.0f;                    // orbit angle of the animated light and point lights
+};
+
+// Advances the scene animation in fixed TimeStep ticks, so its cost and results do not
+// depend on the frame rate. Either start() it on its own thread, or drive it from the
+// caller with advance() (headless runs, which feed fixed deltas to stay repeatable).
+//
+// On the thread, every batch of steps publishes the previous and the new state as one
+// immutable snapshot through a TripleBuffer; the render thread's sample() interpolates
+// between the two, which keeps motion smooth whether frames come faster or slower than steps.
+// While paused or with no animation switched on the thread blocks instead of ticking, until
+// new inputs, a time control or stop() wakes it.
+class Simulation
+{
+public:
+    Simulation() = default;
+    ~Simulation();
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    void start(int rateHz);
+    void stop();
+
+    // Without start(): runs the steps due after `realSeconds` on this thread and returns the
+    // state interpolated at the time left over.
+    void setRate(int rateHz);
+    SimState advance(double realSeconds);
+
+    // Render thread. Hands the current UI settings over; the next step picks them up. Wakes
+    // the thread only when they changed, so calling it every frame is cheap.
+    void setInputs(const SceneSettings& scene);
+    // Render thread. Lags the newest step by up to one step, so it always has a step on either side.
+    SimState sample();
+
+    // Time controls, safe from any thread; applied before the next step.
+    void setTimeScale(float scale) { m_timeScale = scale; wake(); }
+    float timeScale() const { return m_timeScale; }
+    void setPaused(bool paused) { m_paused = paused; wake(); }
+    bool paused() const { return m_paused; }
+    // Runs one step while paused.
+    void singleStep() { m_stepRequests++; wake(); }
+
+    int rate() const { return m_rate; }
+    unsigned long long steps() const { return m_steps.load(std::memory_order_relaxed); }
+    unsigned long long droppedSteps() const { return m_dropped.load(std::memory_order_relaxed); }
+    double stepMs() const { return m_stepMs.load(std::memory_order_relaxed); }
+    // Blend factor between the two states used by the last sample().
+    float interpolation() const { return m_alpha; }
+    // Render thread. True while the last sample() was still blending toward its newer state,
+    // or a singleStep() has not reached sample() yet; the scene is not settled until then.
+    bool blending() const { return m_blending || m_stepRequests.load() != m_stepRequestsSampled; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Inputs {
+        bool upDown = false;
+        bool leftRight = false;
+        bool spin = false;
+        bool animateLight = false;
+        float speed = 1.0f;
+
+        bool animating() const { return upDown || leftRight || spin || animateLight; }
+        bool operator==(const Inputs& o) const {
+            return upDown == o.upDown && leftRight == o.leftRight && spin == o.spin
+                && animateLight == o.animateLight && speed == o.speed;
+        }
+    };
+
+    struct Snapshot {
+        SimState previous;
+        SimState current;
+        double alpha = 0.0;             // blend factor when published
+        double alphaPerSecond = 0.0;    // how fast it grows afterwards; 0 while paused
+        unsigned int stepRequests = 0;  // singleStep() calls applied so far
+        Clock::time_point publishedAt;
+    };
+
+    static glm::vec3 objectOffset(const Inputs& inputs, float phase);
+    static SimState blend(const SimState& a, const SimState& b, float alpha);
+    bool applyControls();
+    void derive(const Inputs& inputs);
+    void runSteps(int steps);
+    void threadMain();
+    void wake();
+    unsigned int wakeups();
+    // Stepping thread: true when waiting for a step could only end in another wait.
+    bool idle();
+
+    std::thread m_thread;
+    std::atomic<bool> m_quit{ false };
+    TripleBuffer<Inputs> m_inputs;          // render thread -> simulation
+    TripleBuffer<Snapshot> m_snapshots;     // simulation -> render thread
+
+    std::atomic<float> m_timeScale{ 1.0f };
+    std::atomic<bool> m_paused{ false };
+    std::atomic<unsigned int> m_stepRequests{ 0 };
+    std::atomic<int> m_rate{ 120 };
+
+    // The thread sleeps on m_wake until m_wakeups moves past the count it started from.
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    unsigned int m_wakeups = 0;
+    Inputs m_sentInputs;        // render thread: last inputs handed over
+    bool m_inputsSent = false;
+
+    // Stepping thread only.
+    TimeStep m_timeStep;
+    unsigned int m_stepRequestsSeen = 0;
+    bool m_initialized = false;
+    SimState m_previous;
+    SimState m_state;
+    double m_phase = 0.0;   // integral of the animation speed
+    double m_spin = 0.0;
+    double m_light = 0.0;
+
+    std::atomic<unsigned long long> m_steps{ 0 };
+    std::atomic<unsigned long long> m_dropped{ 0 };
+    std::atomic<double> m_stepMs{ 0.0 };
+    float m_alpha = 0.0f;
+    bool m_blending = false;                    // render thread
+    unsigned int m_stepRequestsSampled = 0;     // render thread
+};
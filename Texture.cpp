@@ -1,4 +1,5 @@
 #include "Texture.h"
+#include "FrameStats.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include "third_party/stb_image.h"
 #include <iostream>
@@ -44,5 +45,6 @@ void Texture::bind(GLenum unit) const
 {
     glActiveTexture(unit);
     glBindTexture(GL_TEXTURE_2D, m_id);
+    frameStats.glCalls += 2;
 }
 
@@ -0,0 +1,57 @@
+#include "TimeStep.h"
+#include <algorithm>
+#include <cmath>
+
+// Remainders this close to a whole step count as one, so e.g. a 1/60 s frame at 120 Hz is
+// always exactly two steps despite rounding in the accumulator.
+static const double kStepTolerance = 1e-6;
+
+double WallClock::tick()
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - m_last).count();
+    m_last = now;
+    return seconds;
+}
+
+void TimeStep::setRate(int stepsPerSecond)
+{
+    m_step = 1.0 / std::max(stepsPerSecond, 1);
+    m_accumulator = 0.0;
+}
+
+void TimeStep::setTimeScale(double scale)
+{
+    m_scale = std::max(scale, 0.0);
+}
+
+int TimeStep::advance(double realSeconds)
+{
+    if (m_paused) {
+        int steps = m_stepRequests > 0 ? 1 : 0;
+        m_stepRequests = 0;
+        m_steps += steps;
+        return steps;
+    }
+    m_stepRequests = 0;
+
+    m_accumulator += std::max(realSeconds, 0.0) * m_scale;
+    int steps = 0;
+    while (steps < kMaxSteps && m_accumulator >= m_step * (1.0 - kStepTolerance)) {
+        m_accumulator = std::max(m_accumulator - m_step, 0.0);
+        steps++;
+    }
+    if (m_accumulator >= m_step) {
+        double backlog = std::floor(m_accumulator / m_step);
+        m_dropped += static_cast<unsigned long long>(backlog);
+        m_accumulator -= backlog * m_step;
+    }
+    m_steps += steps;
+    return steps;
+}
+
+double TimeStep::secondsUntilStep() const
+{
+    if (m_paused || m_scale <= 0.0) return -1.0;
+    return std::max(m_step - m_accumulator, 0.0) / m_scale;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <chrono>
+
+// Real seconds between calls to tick().
+class WallClock
+{
+public:
+    WallClock() : m_last(std::chrono::steady_clock::now()) {}
+    // Seconds since the previous tick (or construction).
+    double tick();
+
+private:
+    std::chrono::steady_clock::time_point m_last;
+};
+
+// Fixed-tick accumulator: real time goes in through advance(), scaled by the time scale,
+// and comes out as a whole number of steps of exactly stepSeconds() each. What is left
+// over stays in the accumulator; alpha() is that remainder as a fraction of a step, the
+// blend factor between the last two steps' states. Steps never depend on how the real
+// time was sliced, so the same total always gives the same steps.
+class TimeStep
+{
+public:
+    // Longest backlog advance() works off in one call; the rest is dropped so a long stall
+    // (debugger, suspended machine) does not turn into a burst of catch-up steps.
+    static const int kMaxSteps = 8;
+
+    void setRate(int stepsPerSecond);
+    double stepSeconds() const { return m_step; }
+    int rate() const { return static_cast<int>(1.0 / m_step + 0.5); }
+
+    // 1 = real time, 0.5 = half speed; never negative.
+    void setTimeScale(double scale);
+    double timeScale() const { return m_scale; }
+    // While paused real time is ignored and alpha() holds still.
+    void setPaused(bool paused) { m_paused = paused; }
+    bool paused() const { return m_paused; }
+    // While paused: the next advance() runs exactly one step. Ignored otherwise.
+    void requestStep() { m_stepRequests++; }
+
+    // Returns the number of steps to simulate for `realSeconds` of wall time.
+    int advance(double realSeconds);
+
+    double alpha() const { return m_accumulator / m_step; }
+    // Real seconds until the next step is due; negative while paused or scaled to zero.
+    double secondsUntilStep() const;
+
+    unsigned long long steps() const { return m_steps; }
+    unsigned long long droppedSteps() const { return m_dropped; }
+    // Simulated seconds so far: steps() whole steps.
+    double time() const { return m_steps * m_step; }
+
+private:
+    double m_step = 1.0 / 120.0;
+    double m_scale = 1.0;
+    double m_accumulator = 0.0;
+    bool m_paused = false;
+    int m_stepRequests = 0;
+    unsigned long long m_steps = 0;
+    unsigned long long m_dropped = 0;
+};
@@ -0,0 +1,40 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Lock-free hand-off of the latest value from one producer thread to one consumer thread.
+// The producer fills writeSlot() and publish()es it by swapping it with the shared middle
+// slot; the consumer's update() swaps the middle slot into read() only if something newer
+// was published. Neither side ever waits, each owns its slot exclusively, and the consumer
+// always sees a complete value (values published in between are skipped).
+template <typename T>
+class TripleBuffer
+{
+public:
+    // Producer side.
+    T& writeSlot() { return m_slots[m_write]; }
+    void publish()
+    {
+        uint8_t previous = m_middle.exchange(static_cast<uint8_t>(m_write | kFresh), std::memory_order_acq_rel);
+        m_write = previous & kIndexMask;
+    }
+
+    // Consumer side. Returns true if read() now holds a newer value.
+    bool update()
+    {
+        if (!(m_middle.load(std::memory_order_relaxed) & kFresh)) return false;
+        uint8_t previous = m_middle.exchange(m_read, std::memory_order_acq_rel);
+        m_read = previous & kIndexMask;
+        return true;
+    }
+    const T& read() const { return m_slots[m_read]; }
+
+private:
+    static constexpr uint8_t kIndexMask = 0x3;
+    static constexpr uint8_t kFresh = 0x4;  // set in m_middle when it holds an unread value
+
+    T m_slots[3] = {};
+    uint8_t m_write = 0;
+    std::atomic<uint8_t> m_middle{ 1 };
+    uint8_t m_read = 2;
+};
@@ -0,0 +1,69 @@
+#include "UniformRingBuffer.h"
+#include "FrameStats.h"
+#include "GlErrors.h"
+#include <cstring>
+#include <iostream>
+
+UniformRingBuffer::~UniformRingBuffer()
+{
+    for (GLsync& fence : m_fences) {
+        if (fence) glDeleteSync(fence);
+    }
+    if (m_buffer) glDeleteBuffers(1, &m_buffer);
+}
+
+bool UniformRingBuffer::init(GLsizeiptr blockSize)
+{
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    m_stride = (blockSize + alignment - 1) / alignment * alignment;
+
+    // Errors left by earlier calls must not count as this allocation's.
+    ClearGlErrors("UniformRingBuffer::init");
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+    glBufferData(GL_UNIFORM_BUFFER, m_stride * kSegments, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    if (glGetError() != GL_NO_ERROR) {
+        std::cerr << "Failed to create uniform ring buffer\n";
+        return false;
+    }
+    return true;
+}
+
+void UniformRingBuffer::upload(const void* data, GLsizeiptr size, GLuint bindingPoint)
+{
+    m_current = (m_current + 1) % kSegments;
+
+    GLsync& fence = m_fences[m_current];
+    if (fence) {
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            m_stalls++;
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+        frameStats.glCalls += 2;
+    }
+
+    GLintptr offset = m_stride * m_current;
+    glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+    // The fence above guarantees the GPU is done with this slice, so skip the driver's own sync.
+    void* dst = glMapBufferRange(GL_UNIFORM_BUFFER, offset, size,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (dst) {
+        std::memcpy(dst, data, size);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+    }
+    glBindBufferRange(GL_UNIFORM_BUFFER, bindingPoint, m_buffer, offset, size);
+    frameStats.glCalls += 4;
+}
+
+void UniformRingBuffer::endFrame()
+{
+    if (m_fences[m_current]) glDeleteSync(m_fences[m_current]);
+    m_fences[m_current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frameStats.glCalls++;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <GL/glew.h>
+
+// A uniform buffer split into kSegments slices that are written round-robin.
+// Each slice is fenced after the frame that used it, so the CPU only waits when
+// the GPU falls more than kSegments - 1 frames behind.
+class UniformRingBuffer
+{
+public:
+    static constexpr int kSegments = 3;
+
+    UniformRingBuffer() = default;
+    ~UniformRingBuffer();
+    UniformRingBuffer(const UniformRingBuffer&) = delete;
+    UniformRingBuffer& operator=(const UniformRingBuffer&) = delete;
+
+    bool init(GLsizeiptr blockSize);
+
+    // Copies `size` bytes into the next free slice and binds it to `bindingPoint`.
+    void upload(const void* data, GLsizeiptr size, GLuint bindingPoint);
+
+    // Fences the slice written by the last upload(). Call once all draws reading it are issued.
+    void endFrame();
+
+    unsigned int stalls() const { return m_stalls; }
+
+private:
+    GLuint m_buffer = 0;
+    GLsizeiptr m_stride = 0;
+    GLsync m_fences[kSegments] = {};
+    int m_current = 0;
+    unsigned int m_stalls = 0;
+};
@@ -1,72 +1,53 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <algorithm>
 #include <iostream>
-#include <fstream>
-#include <sstream>
-#include "Mesh.h"
+#include <cstring>
+#include <memory>
 
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 
 #include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include "Config.h"
-#include "ResourceManager.h"
-#include "Texture.h"
 #include "SoundSystem.h"
+#include "FrameStats.h"
+#include "Renderer.h"
+#include "SceneSettings.h"
+#include "Headless.h"
+#include "FrameCapture.h"
+#include "JobSystem.h"
+#include "MeshPool.h"
+#include "Profiler.h"
+#include "ProfilerWindow.h"
+#include "Simulation.h"
 
-bool is3DMode = false;
-bool useTexture = false;
-std::string texturePath = "";
 std::string audioPath = "";
 
-std::string LoadShaderSource(const std::string& filepath) {
-    std::ifstream file(filepath);
-    if (!file) {
-        std::cerr << "Failed to load shader: " << filepath << std::endl;
-        return "";
+// Set by any window or input event; idle mode only redraws when something happened.
+bool inputDirty = true;
+
+static void onRefresh(GLFWwindow*) { inputDirty = true; }
+static void onCursorPos(GLFWwindow*, double, double) { inputDirty = true; }
+static void onMouseButton(GLFWwindow*, int, int, int) { inputDirty = true; }
+static void onScroll(GLFWwindow*, double, double) { inputDirty = true; }
+static void onKey(GLFWwindow*, int, int, int, int) { inputDirty = true; }
+static void onChar(GLFWwindow*, unsigned int) { inputDirty = true; }
+static void onSize(GLFWwindow*, int, int) { inputDirty = true; }
+static void onFocusOrEnter(GLFWwindow*, int) { inputDirty = true; }
+
+// Last resolved GPU time of the profiler pass called `name`; 0 if it did not run (or profiling is compiled out).
+static double gpuPassMs(const char* name)
+{
+    for (const GpuTiming& t : profiler.lastGpuTimings()) {
+        if (std::strcmp(t.name, name) == 0) return t.ms;
     }
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
+    return 0.0;
 }
 
-GLuint CompileShader(GLenum type, const std::string& source) {
-    GLuint shader = glCreateShader(type);
-    const char* src = source.c_str();
-    glShaderSource(shader, 1, &src, nullptr);
-    glCompileShader(shader);
-
-    GLint success;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetShaderInfoLog(shader, 512, nullptr, infoLog);
-        std::cerr << "Shader compile error:\n" << infoLog << std::endl;
-    }
-    return shader;
-}
-
-GLuint CreateShaderProgram(const std::string& vertexPath, const std::string& fragmentPath) {
-    std::string vertexCode = LoadShaderSource(vertexPath);
-    std::string fragmentCode = LoadShaderSource(fragmentPath);
-
-    GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, vertexCode);
-    GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentCode);
-
-    GLuint program = glCreateProgram();
-    glAttachShader(program, vertexShader);
-    glAttachShader(program, fragmentShader);
-    glLinkProgram(program);
-
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-    return program;
-}
-
-int main() {
+int main(int argc, char** argv) {
     // Load engine config
     Config config;
     config.loadFromFile("config/engine.ini");
@@ -74,10 +55,38 @@ int main() {
     int winW = config.getInt("window_width", 1600);
     int winH = config.getInt("window_height", 900);
     std::string winTitle = config.getString("window_title", "Simple 3D Object");
-    is3DMode = config.getBool("start_3d", false);
-    useTexture = config.getBool("use_texture", false);
-    texturePath = config.getString("texture_path", "textures/Metal/Metal053C_1K-JPG_Color.jpg");
     audioPath = config.getString("audio_wav_path", "");
+
+    SceneSettings scene;
+    scene.is3DMode = config.getBool("start_3d", false);
+    scene.useTexture = config.getBool("use_texture", false);
+    scene.shadowsEnabled = config.getBool("shadow_enabled", true);
+    scene.shadowPcfRadius = config.getInt("shadow_pcf_radius", 1);
+    scene.pointLights = config.getBool("point_lights", false);
+    scene.pointLightCount = std::clamp(config.getInt("point_light_count", 256), 1, ClusteredLights::kMaxLights);
+    scene.depthPrepass = config.getBool("depth_prepass", false);
+    scene.occlusionCulling = config.getBool("occlusion_culling", true);
+    scene.postProcess = config.getBool("post_process", false);
+    scene.tonemap = config.getBool("tonemap", true);
+    scene.fxaa = config.getBool("fxaa", true);
+    scene.bloom = config.getBool("bloom", false);
+    scene.exposure = config.getFloat("exposure", 1.0f);
+    scene.bloomThreshold = config.getFloat("bloom_threshold", 1.0f);
+    scene.bloomIntensity = config.getFloat("bloom_intensity", 0.1f);
+    scene.dynamicResolution = config.getBool("dynamic_resolution", false);
+    scene.meshLod = config.getBool("mesh_lod", true);
+    scene.lodPixelError = config.getFloat("lod_pixel_error", 1.0f);
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            HeadlessOptions options;
+            options.width = winW;
+            options.height = winH;
+            if (!ParseHeadlessArgs(argc, argv, options, scene)) return -1;
+            return RunHeadless(config, scene, options);
+        }
+    }
+
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW\n";
         return -1;
@@ -95,31 +104,68 @@ int main() {
     }
     glfwMakeContextCurrent(window);
 
+    // Declared before any GL object below, so it is destroyed after all of them: their
+    // destructors still have a context to delete from.
+    struct WindowGuard {
+        GLFWwindow* window;
+        ~WindowGuard() {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+        }
+    } windowGuard{ window };
+
     glewExperimental = GL_TRUE;
     if (glewInit() != GLEW_OK) {
         std::cerr << "Failed to initialize GLEW\n";
         return -1;
     }
 
+    // Installed before the ImGui backend, which chains to whatever callbacks already exist.
+    glfwSetCursorPosCallback(window, onCursorPos);
+    glfwSetMouseButtonCallback(window, onMouseButton);
+    glfwSetScrollCallback(window, onScroll);
+    glfwSetKeyCallback(window, onKey);
+    glfwSetCharCallback(window, onChar);
+    glfwSetWindowSizeCallback(window, onSize);
+    glfwSetFramebufferSizeCallback(window, onSize);
+    glfwSetWindowRefreshCallback(window, onRefresh);
+    glfwSetWindowFocusCallback(window, onFocusOrEnter);
+    glfwSetCursorEnterCallback(window, onFocusOrEnter);
+
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init("#version 330 core");
     ImGui::StyleColorsDark();
 
-    glViewport(0, 0, winW, winH);
-    glEnable(GL_DEPTH_TEST);
+    profiler.init();
+    jobSystem.init(config.getInt("job_threads", 0));
+    auto renderer = std::make_unique<Renderer>();
+    if (!renderer->init(config)) {
+        std::cerr << "Failed to initialize renderer\n";
+        renderer.reset();
+        meshPool.shutdown();
+        jobSystem.shutdown();
+        profiler.shutdown();
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui::DestroyContext();
+        return -1;
+    }
+    if (!renderer->shadowMapReady()) scene.shadowsEnabled = false;
+    if (config.getBool("shader_hot_reload", true))
+        renderer->enableShaderHotReload([] { glfwPostEmptyEvent(); });
+    if (scene.useTexture && !renderer->loadTexture()) {
+        scene.useTexture = false; // fallback if load failed
+    }
+    FrameStats lastFrameStats;
 
-    GLuint shaderProgram = CreateShaderProgram("shaders/basic.vert", "shaders/basic.frag");
+    FrameCapture capture;
+    capture.init(config.getString("capture_dir", "captures"), config.getInt("capture_fps", 60));
 
-    ResourceManager resources;
-    std::shared_ptr<Texture> tex;
-    if (useTexture) {
-        tex = resources.getTexture(texturePath);
-        if (!tex) {
-            useTexture = false; // fallback if load failed
-        }
-    }
+    Simulation simulation;
+    simulation.setInputs(scene);
+    simulation.start(config.getInt("sim_rate", 120));
 
     // Initialize sound system
     SoundSystem sound;
@@ -130,29 +176,50 @@ int main() {
         sound.playWavFile(audioPath, playLoop);
     }
 
-    enum ShapeType { TRIANGLE, RECTANGLE, CIRCLE, PYRAMID };
-    ShapeType currentShape = TRIANGLE;
+    bool traceKeyDown = false;
 
-    Mesh* triangle = Mesh::CreateTriangle();
-    Mesh* rectangle = Mesh::CreateQuad();
-    Mesh* circle = Mesh::CreateCircle();
-    Mesh* pyramid = Mesh::CreatePyramid();
-    Mesh* backdrop = Mesh::CreateBackdropPlane();
+    bool idleMode = config.getBool("idle_mode", true);
+    const double idleTimeout = 0.5;     // seconds between wake-ups with no events
+    // ImGui settles hover/active state over a couple of frames after the last event.
+    const int kSettleFrames = 3;
+    int settleFrames = kSettleFrames;
+    double refreshRate = 60.0;
+    if (const GLFWvidmode* mode = glfwGetVideoMode(glfwGetPrimaryMonitor())) refreshRate = mode->refreshRate;
+    unsigned long long renderedFrames = 0;
+    unsigned long long skippedFrames = 0;   // frames a full-rate loop would have drawn while idle
 
-    glm::vec3 lightColor(1.0f, 1.0f, 1.0f);
-    float lightIntensity = 5.0f;
-    bool animateLight = false;
+    while (!glfwWindowShouldClose(window)) {
+        // Paused or at zero time scale the animation holds still, apart from a step still blending in.
+        const bool simulationStopped = simulation.paused() || simulation.timeScale() <= 0.0f;
+        bool animating = (scene.isAnimating() && !simulationStopped) || simulation.blending()
+            || ImGui::GetIO().WantTextInput || capture.busy() || renderer->shaderReloadBusy();
+        if (idleMode && !animating && settleFrames == 0 && !inputDirty) {
+            double waitStart = glfwGetTime();
+            glfwWaitEventsTimeout(idleTimeout);
+            skippedFrames += static_cast<unsigned long long>((glfwGetTime() - waitStart) * refreshRate + 0.5);
+            if (!inputDirty) continue;
+        }
+        // Follow window resizes; a minimized window has a 0x0 framebuffer and nothing to draw.
+        glfwGetFramebufferSize(window, &winW, &winH);
+        if (winW <= 0 || winH <= 0) {
+            glfwWaitEvents();
+            continue;
+        }
+        if (inputDirty) settleFrames = kSettleFrames;
+        else if (settleFrames > 0) settleFrames--;
+        inputDirty = false;
+        renderedFrames++;
 
-    bool toggleUpDown = false;
-    bool toggleLeftRight = false;
-    bool toggleSpin = false;
-    float animationSpeed = 1.0f;
-    float timeOffset = 0.0f;
+        frameStats.reset();
+        profiler.beginFrame();
 
-    while (!glfwWindowShouldClose(window)) {
         if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
             glfwSetWindowShouldClose(window, true);
 
+        bool traceKey = glfwGetKey(window, GLFW_KEY_F9) == GLFW_PRESS;
+        if (traceKey && !traceKeyDown) profiler.writeChromeTrace("profile_trace.json");
+        traceKeyDown = traceKey;
+
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
@@ -161,38 +228,122 @@ int main() {
         ImGui::Begin("Shape & Lighting", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse);
         ImGui::SetWindowPos(ImVec2(10, 10));
 
-        ImGui::Checkbox("Enable 3D Mode", &is3DMode);
+        ImGui::Checkbox("Enable 3D Mode", &scene.is3DMode);
         const char* lightOptions[] = { "Top-Left", "Bottom-Right", "Front" };
-        static int selectedLight = 0;
-        ImGui::Combo("Light Direction", &selectedLight, lightOptions, IM_ARRAYSIZE(lightOptions));
-        ImGui::Checkbox("Animate Light", &animateLight);
+        ImGui::Combo("Light Direction", &scene.lightPreset, lightOptions, IM_ARRAYSIZE(lightOptions));
+        ImGui::Checkbox("Animate Light", &scene.animateLight);
 
         ImGui::Separator();
         ImGui::Text("Shape");
-        if (ImGui::Button("Show Triangle")) currentShape = TRIANGLE;
-        if (ImGui::Button("Show Rectangle")) currentShape = RECTANGLE;
-        if (ImGui::Button("Show Circle")) currentShape = CIRCLE;
-        if (ImGui::Button("Show Pyramid")) currentShape = PYRAMID;
+        if (ImGui::Button("Show Triangle")) scene.shape = TRIANGLE;
+        if (ImGui::Button("Show Rectangle")) scene.shape = RECTANGLE;
+        if (ImGui::Button("Show Circle")) scene.shape = CIRCLE;
+        if (ImGui::Button("Show Pyramid")) scene.shape = PYRAMID;
+        if (ImGui::Button("Show Sphere")) scene.shape = SPHERE;
 
         ImGui::Separator();
         ImGui::Text("Rendering");
-        if (ImGui::Checkbox("Use Texture", &useTexture)) {
-            if (useTexture && !tex) {
-                tex = resources.getTexture(texturePath);
-                if (!tex) useTexture = false;
+        if (ImGui::Checkbox("Use Texture", &scene.useTexture)) {
+            if (scene.useTexture && !renderer->hasTexture()) {
+                if (!renderer->loadTexture()) scene.useTexture = false;
             }
         }
         if (ImGui::Button("Reload Texture")) {
-            tex = resources.getTexture(texturePath);
+            renderer->loadTexture();
+        }
+        ImGui::Text("Texture: %s", renderer->texturePath().c_str());
+        if (renderer->shadowMapReady()) ImGui::Checkbox("Shadows", &scene.shadowsEnabled);
+        ImGui::SliderInt("PCF Radius", &scene.shadowPcfRadius, 0, 3);
+        ImGui::Text("Shadow map: %d px, %d cascade(s)", renderer->shadowMap().resolution(), renderer->shadowMap().cascades());
+        if (renderer->clusteredLightsReady()) {
+            ImGui::Checkbox("Point Lights (3D)", &scene.pointLights);
+            ImGui::SliderInt("Point Light Count", &scene.pointLightCount, 1, ClusteredLights::kMaxLights, "%d", ImGuiSliderFlags_Logarithmic);
+            if (scene.pointLights && scene.is3DMode) {
+                const ClusteredLights& clusters = renderer->clusteredLights();
+                ImGui::Text("Binning: %.3f ms on %d thread(s), %zu indices, max %u per cluster", clusters.binMs(),
+                    jobSystem.threadCount(), clusters.indexCount(), clusters.maxLightsPerCluster());
+            }
+        }
+
+        ImGui::Checkbox("Depth Pre-pass", &scene.depthPrepass);
+        ImGui::SameLine();
+        ImGui::Checkbox("Overdraw View", &scene.overdrawView);
+        ImGui::Text("Shaded fragments: %.2f per pixel", static_cast<double>(renderer->shadedFragments())
+            / std::max(1.0, static_cast<double>(renderer->renderWidth()) * renderer->renderHeight()));
+
+        ImGui::Checkbox("Mesh LOD", &scene.meshLod);
+        ImGui::SliderFloat("LOD Pixel Error", &scene.lodPixelError, 0.1f, 8.0f, "%.1f px");
+        if (!renderer->lodCounts().empty()) {
+            std::string levels;
+            for (unsigned int count : renderer->lodCounts()) levels += " " + std::to_string(count);
+            ImGui::Text("Objects per level (finest first):%s", levels.c_str());
+        }
+        ImGui::Text("Mesh pool: %zu meshes, %d/%d vertices, %d/%d indices, %.1f MB", meshPool.meshCount(),
+            meshPool.vertexSpace().used(), meshPool.vertexSpace().capacity(), meshPool.indexSpace().used(),
+            meshPool.indexSpace().capacity(), meshPool.memoryBytes() / (1024.0 * 1024.0));
+
+        ImGui::Checkbox("Dynamic Resolution", &scene.dynamicResolution);
+        const DynamicResolution& resolution = renderer->dynamicResolution();
+        ImGui::Text("Scene %dx%d for %dx%d window (scale %.2f of %.2f-%.2f)", renderer->renderWidth(),
+            renderer->renderHeight(), winW, winH, resolution.scale(), resolution.minScale(), resolution.maxScale());
+        if (scene.dynamicResolution)
+            ImGui::Text("GPU frame: %.2f ms average, target %.1f ms", resolution.averageMs(), resolution.targetMs());
+
+        ImGui::Separator();
+        ImGui::Text("Post-processing");
+        if (renderer->postProcessReady()) {
+            ImGui::Checkbox("Enabled (HDR target)", &scene.postProcess);
+            ImGui::Checkbox("Bloom", &scene.bloom);
+            ImGui::SameLine();
+            ImGui::Text("%.3f ms", gpuPassMs("Bloom"));
+            ImGui::SliderFloat("Bloom Threshold", &scene.bloomThreshold, 0.0f, 5.0f);
+            ImGui::SliderFloat("Bloom Intensity", &scene.bloomIntensity, 0.0f, 1.0f);
+            ImGui::Checkbox("Tonemap", &scene.tonemap);
+            ImGui::SameLine();
+            ImGui::Text("%.3f ms", gpuPassMs("Tonemap"));
+            ImGui::SliderFloat("Exposure", &scene.exposure, 0.1f, 4.0f);
+            ImGui::Checkbox("FXAA", &scene.fxaa);
+            ImGui::SameLine();
+            ImGui::Text("%.3f ms", gpuPassMs("FXAA"));
+            const RenderTargetPool& targets = renderer->renderTargets();
+            ImGui::Text("Render targets: %zu pooled, %.1f MB, %u created", targets.targetCount(),
+                targets.memoryBytes() / (1024.0 * 1024.0), targets.created());
+        }
+        else {
+            ImGui::TextDisabled("Unavailable");
         }
-        ImGui::Text("Texture: %s", texturePath.c_str());
 
         ImGui::Separator();
         ImGui::Text("Animation");
-        ImGui::Checkbox("Move Up & Down", &toggleUpDown);
-        ImGui::Checkbox("Move Left & Right", &toggleLeftRight);
-        ImGui::Checkbox("Spin", &toggleSpin);
-        ImGui::SliderFloat("Speed", &animationSpeed, 0.1f, 5.0f);
+        ImGui::Checkbox("Move Up & Down", &scene.toggleUpDown);
+        ImGui::Checkbox("Move Left & Right", &scene.toggleLeftRight);
+        ImGui::Checkbox("Spin", &scene.toggleSpin);
+        ImGui::SliderFloat("Speed", &scene.animationSpeed, 0.1f, 5.0f);
+        bool simPaused = simulation.paused();
+        if (ImGui::Checkbox("Pause", &simPaused)) simulation.setPaused(simPaused);
+        ImGui::SameLine();
+        if (ImGui::Button("Step") && simPaused) simulation.singleStep();
+        float timeScale = simulation.timeScale();
+        if (ImGui::SliderFloat("Time Scale", &timeScale, 0.0f, 4.0f)) simulation.setTimeScale(timeScale);
+        ImGui::Text("Simulation: %d Hz, %llu steps (%llu dropped), %.3f ms per step, blend %.2f", simulation.rate(),
+            simulation.steps(), simulation.droppedSteps(), simulation.stepMs(), simulation.interpolation());
+
+        ImGui::Separator();
+        ImGui::Text("Stress Scene");
+        ImGui::Checkbox("Instanced", &scene.instancedScene);
+        ImGui::SliderInt("Instance Count", &scene.instanceCount, 1, 100000, "%d", ImGuiSliderFlags_Logarithmic);
+        ImGui::Checkbox("Separate Draws", &scene.separateDraws);
+        if (scene.instancedScene && scene.separateDraws) {
+            const DrawPacketStats& packets = renderer->drawPacketStats();
+            ImGui::Text("Draw packets: %zu, record %.3f ms on %d thread(s), merge %.3f ms", packets.packets,
+                packets.recordMs, packets.threads, packets.mergeMs);
+        }
+        ImGui::Checkbox("Occlusion Culling (3D)", &scene.occlusionCulling);
+        if (scene.occlusionCulling && scene.is3DMode) {
+            const OcclusionCuller& occlusion = renderer->occlusionCuller();
+            ImGui::Text("Occlusion: %zu occluder tris, raster %.3f ms + test %.3f ms on %d thread(s)",
+                occlusion.triangleCount(), occlusion.rasterMs(), occlusion.testMs(), jobSystem.threadCount());
+        }
 
         ImGui::Separator();
         ImGui::Text("Audio");
@@ -204,126 +355,81 @@ int main() {
         if (ImGui::Button("Stop Audio")) sound.stop();
 
         ImGui::Separator();
-        ImGui::ColorEdit3("Light Color", glm::value_ptr(lightColor));
-        ImGui::End();
+        ImGui::ColorEdit3("Light Color", glm::value_ptr(scene.lightColor));
 
+        ImGui::Separator();
+        ImGui::Text("Stats (last frame)");
+        ImGui::Text("GL calls: %u  draws: %u  triangles: %llu", lastFrameStats.glCalls, lastFrameStats.drawCalls,
+            lastFrameStats.triangles);
+        ImGui::Text("Uniform uploads: %u  name lookups: %u", lastFrameStats.uniformUploads, lastFrameStats.uniformLookups);
+        ImGui::Text("Frame UBO stalls: %u", renderer->frameUniforms().stalls());
+        ImGui::Text("Culling: %u visible, %u culled (%u occluded)", lastFrameStats.visibleObjects,
+            lastFrameStats.culledObjects, lastFrameStats.occludedObjects);
+        ImGui::Text("Queued: %u  binds: program %u, texture %u, VAO %u", lastFrameStats.queuedItems,
+            lastFrameStats.programBinds, lastFrameStats.textureBinds, lastFrameStats.vaoBinds);
+        const FrameGraph& graph = renderer->frameGraph();
+        ImGui::Text("Frame graph: %zu passes (%zu culled), transients peak %.1f MB on %zu targets", graph.passCount(),
+            graph.culledPassCount(), graph.peakTransientBytes() / (1024.0 * 1024.0), graph.aliasedTargetCount());
+        ImGui::SameLine();
+        if (ImGui::Button("Dump")) std::cout << graph.dump();
 
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glUseProgram(shaderProgram);
-
-        float time = glfwGetTime();
-        timeOffset = time * animationSpeed;
-
-        glm::vec3 positionOffset(0.0f);
-        if (toggleUpDown) {
-            positionOffset.y += sin(timeOffset) * 0.5f;
+        ImGui::Separator();
+        ImGui::Text("Capture");
+        if (ImGui::Button("Screenshot")) capture.takeScreenshot();
+        ImGui::SameLine();
+        if (capture.mode() == FrameCapture::Mode::Video) {
+            if (ImGui::Button("Stop Video")) capture.stop();
         }
-        if (toggleLeftRight) {
-            positionOffset.x += sin(timeOffset) * 0.5f;
+        else if (ImGui::Button("Record Y4M")) capture.startVideo();
+        ImGui::SameLine();
+        if (capture.mode() == FrameCapture::Mode::PngSequence) {
+            if (ImGui::Button("Stop PNGs")) capture.stop();
         }
+        else if (ImGui::Button("Record PNGs")) capture.startPngSequence();
+        ImGui::Text("Render thread cost: %.3f ms last, %.3f ms avg, %.3f ms max",
+            capture.lastCostMs(), capture.averageCostMs(), capture.maxCostMs());
+        ImGui::Text("Written %u  dropped %u  queued %zu", capture.framesWritten(), capture.framesDropped(), capture.queuedFrames());
 
-        glm::vec3 lightPresets[] = {
-            glm::normalize(glm::vec3(-0.5f, 1.0f, 0.3f)),
-            glm::normalize(glm::vec3(1.0f, -1.0f, -0.2f)),
-            glm::normalize(glm::vec3(0.0f, 0.0f, -1.0f))
-        };
-        glm::vec3 lightDir = animateLight ? glm::normalize(glm::vec3(cos(time), 1.0f, sin(time))) : lightPresets[selectedLight];
-        glm::vec3 effectiveLight = lightColor * lightIntensity;
-        glm::vec3 cameraPos = glm::vec3(0.0f, 0.0f, 2.0f);
-
-        glm::mat4 view = glm::mat4(1.0f);
-        glm::mat4 projection = glm::mat4(1.0f);
-        if (is3DMode) {
-            view = glm::lookAt(cameraPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-            projection = glm::perspective(glm::radians(45.0f), 1600.0f / 900.0f, 0.1f, 100.0f);
-        }
+        ImGui::Separator();
+        ImGui::Checkbox("Idle When Static", &idleMode);
+        ImGui::Text("Frames rendered: %llu  skipped: %llu", renderedFrames, skippedFrames);
 
-        float d = -0.6f;
-        glm::mat4 projectionMat = glm::mat4(
-            1, 0, 0, 0,
-            -lightDir.x / lightDir.y, 0, -lightDir.z / lightDir.y, 0,
-            0, 0, 1, 0,
-            0, d, 0, 1
-        );
-
-        glm::vec3 moveOffset(0.0f);
-        if (toggleUpDown)
-            moveOffset.y = sin(time * animationSpeed) * 0.5f;
-        if (toggleLeftRight)
-            moveOffset.x = cos(time * animationSpeed) * 0.5f;
-
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, positionOffset + moveOffset);
-
-        glm::mat4 backdropModel = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.6f, 0.0f));
-
-
-        if (toggleSpin)
-            model = glm::rotate(model, time * animationSpeed, is3DMode ? glm::vec3(0.3f, 1.0f, 0.0f) : glm::vec3(0.0f, 0.0f, 1.0f));
-
-       
-        // Set common uniforms
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "lightDir"), 1, glm::value_ptr(lightDir));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "lightColor"), 1, glm::value_ptr(effectiveLight));
-        glUniform3fv(glGetUniformLocation(shaderProgram, "viewPos"), 1, glm::value_ptr(cameraPos));
-        glUniform1f(glGetUniformLocation(shaderProgram, "time"), time);
-        glUniform1i(glGetUniformLocation(shaderProgram, "useTexture"), useTexture ? 1 : 0);
-        if (useTexture && tex) {
-            tex->bind(GL_TEXTURE0);
-            glUniform1i(glGetUniformLocation(shaderProgram, "tex0"), 0);
-        }
+        if (ImGui::CollapsingHeader("Profiler")) DrawProfilerTimeline(profiler);
+        ImGui::End();
 
-        //DRAW BACKDROP
-        glUniform1i(glGetUniformLocation(shaderProgram, "isShadow"), 0);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(backdropModel));
-        backdrop->Draw();
-
-        //DRAW SHADOW
-        glm::mat4 shadowModel = projectionMat * model;
-        glUniform1i(glGetUniformLocation(shaderProgram, "isShadow"), 1);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(shadowModel));
-
-        switch (currentShape) {
-        case TRIANGLE: triangle->Draw(); break;
-        case RECTANGLE: rectangle->Draw(); break;
-        case CIRCLE: circle->Draw(); break;
-        case PYRAMID: pyramid->Draw(); break;
-        }
+        renderer->updateShaderReloads();
 
-        //DRAW MAIN OBJECT
-        glUniform1i(glGetUniformLocation(shaderProgram, "isShadow"), 0); // Restore
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
+        simulation.setInputs(scene);
+        renderer->renderFrame(scene, simulation.sample(), winW, winH);
+        // Before the UI is drawn, so captures show only the scene.
+        capture.captureFrame(0, winW, winH);
 
-        switch (currentShape) {
-        case TRIANGLE: triangle->Draw(); break;
-        case RECTANGLE: rectangle->Draw(); break;
-        case CIRCLE: circle->Draw(); break;
-        case PYRAMID: pyramid->Draw(); break;
+        {
+            PROFILE_SCOPE("ImGui render");
+            PROFILE_GPU_SCOPE("ImGui");
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+        {
+            PROFILE_SCOPE("Swap");
+            glfwSwapBuffers(window);
         }
-
-
-
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-        glfwSwapBuffers(window);
         glfwPollEvents();
+
+        lastFrameStats = frameStats;
     }
 
-    delete triangle;
-    delete rectangle;
-    delete circle;
-    delete pyramid;
-    delete backdrop;
-    glDeleteProgram(shaderProgram);
+    // GL objects have to go before the context does.
+    simulation.stop();
+    capture.shutdown();
+    renderer.reset();
+    meshPool.shutdown();
+    jobSystem.shutdown();
+    profiler.shutdown();
     sound.shutdown();
 
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
-    glfwDestroyWindow(window);
-    glfwTerminate();
     return 0;
 }
@@ -1,5 +1,8 @@
 #version 330 core
 
+// Variants: SHADOW samples the cascaded shadow map, TEXTURED replaces the vertex color with tex0,
+// CLUSTERED adds the point lights binned by ClusteredLights.
+
 in vec3 FragPos;
 in vec3 Normal;
 in vec3 vColor;
@@ -7,42 +10,52 @@ in vec2 vTexCoord;
 
 out vec4 FragColor;
 
-uniform vec3 lightDir;
-uniform vec3 viewPos;
-uniform vec3 lightColor;
-uniform int isShadow;
-uniform int useTexture;
+#include "frame_data.glsl"
+
+#ifdef TEXTURED
 uniform sampler2D tex0;
+#endif
+
+#ifdef SHADOW
+#include "shadow.glsl"
+#endif
+
+#ifdef CLUSTERED
+#include "clustered.glsl"
+#endif
 
 void main()
 {
-    if (isShadow == 1) {
-        FragColor = vec4(0.0, 0.0, 0.0, 0.3); // Transparent black shadow
-        return;
-    }
-
     vec3 norm = normalize(Normal);
-    vec3 light = normalize(lightDir);
+    vec3 light = normalize(lightDir.xyz);
 
     // Ambient
     vec3 ambient = 0.3 * vColor;
 
     // Diffuse (Lambert)
     float diff = max(dot(norm, light), 0.0);
-    vec3 diffuse = diff * vColor * lightColor;
+    vec3 diffuse = diff * vColor * lightColor.rgb;
 
     // Specular (Blinn-Phong)
-    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 viewDir = normalize(viewPos.xyz - FragPos);
     vec3 halfwayDir = normalize(light + viewDir);
     float spec = pow(max(dot(norm, halfwayDir), 0.0), 32.0); // shininess
-    vec3 specular = spec * lightColor;
+    vec3 specular = spec * lightColor.rgb;
 
+#ifdef TEXTURED
+    vec3 baseColor = texture(tex0, vTexCoord).rgb;
+#else
     vec3 baseColor = vColor;
-    if (useTexture == 1) {
-        vec4 texColor = texture(tex0, vTexCoord);
-        baseColor = texColor.rgb;
-    }
-
-    vec3 result = ambient + diffuse * baseColor + specular;
+#endif
+
+#ifdef SHADOW
+    float shadow = ShadowFactor(FragPos, norm, light);
+#else
+    float shadow = 1.0;
+#endif
+    vec3 result = ambient + shadow * (diffuse * baseColor + specular);
+#ifdef CLUSTERED
+    result += ClusteredPointLights(FragPos, norm, viewDir, vColor * baseColor);
+#endif
     FragColor = vec4(result, 1.0);
 }
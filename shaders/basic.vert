@@ -1,26 +1,44 @@
 #version 330 core
 
+// Variants: INSTANCED reads a per-instance transform and tint on top of `model`;
+// without it the tint comes from the `tint` uniform.
+
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aColor;
 layout(location = 2) in vec2 aTexCoord;
 layout(location = 3) in vec3 aNormal;
+#ifdef INSTANCED
+layout(location = 4) in mat4 aInstanceModel; // occupies locations 4-7
+layout(location = 8) in vec4 aInstanceTint;
+layout(location = 9) in mat3 aInstanceNormalMatrix; // occupies locations 9-11
+#endif
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec3 vColor;
 out vec2 vTexCoord;
 
+#include "frame_data.glsl"
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform mat3 normalMatrix; // inverse-transpose of model's upper 3x3, computed on the CPU
+#ifndef INSTANCED
+uniform vec3 tint;
+#endif
+
+#include "transform.glsl"
 
 void main()
 {
-    vec4 worldPos = model * vec4(aPos, 1.0);
+    vec4 worldPos = WorldPosition(aPos);
+#ifdef INSTANCED
+    Normal = normalMatrix * (aInstanceNormalMatrix * aNormal);
+    vColor = aColor * aInstanceTint.rgb;
+#else
+    Normal = normalMatrix * aNormal;
+    vColor = aColor * tint;
+#endif
     FragPos = vec3(worldPos);
-    Normal = mat3(transpose(inverse(model))) * aNormal; // correct for non-uniform scaling
-    vColor = aColor;
     vTexCoord = aTexCoord;
     gl_Position = projection * view * worldPos;
 }
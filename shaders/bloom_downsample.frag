@@ -0,0 +1,34 @@
+#version 330 core
+
+// One step down the bloom mip chain: 13 bilinear taps in overlapping 4x4 boxes, which
+// keeps bright single pixels from flickering as they move.
+// Variants: PREFILTER keeps only the energy above `threshold` (first step, reading the HDR scene).
+
+in vec2 vUV;
+
+out vec4 FragColor;
+
+uniform sampler2D source;
+uniform vec2 texelSize;     // of `source`
+#ifdef PREFILTER
+uniform float threshold;
+#endif
+
+vec3 Tap(float x, float y)
+{
+    return texture(source, vUV + vec2(x, y) * texelSize).rgb;
+}
+
+void main()
+{
+    vec3 outer = Tap(-2.0, 2.0) + Tap(2.0, 2.0) + Tap(-2.0, -2.0) + Tap(2.0, -2.0);
+    vec3 cross = Tap(0.0, 2.0) + Tap(-2.0, 0.0) + Tap(2.0, 0.0) + Tap(0.0, -2.0);
+    vec3 inner = Tap(-1.0, 1.0) + Tap(1.0, 1.0) + Tap(-1.0, -1.0) + Tap(1.0, -1.0);
+    vec3 color = Tap(0.0, 0.0) * 0.125 + outer * 0.03125 + cross * 0.0625 + inner * 0.125;
+
+#ifdef PREFILTER
+    float brightness = max(color.r, max(color.g, color.b));
+    color *= max(brightness - threshold, 0.0) / max(brightness, 1e-4);
+#endif
+    FragColor = vec4(color, 1.0);
+}
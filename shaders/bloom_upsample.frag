@@ -0,0 +1,23 @@
+#version 330 core
+
+// One step up the bloom mip chain: a 3x3 tent filter over the smaller mip, added onto the
+// next larger one with additive blending.
+
+in vec2 vUV;
+
+out vec4 FragColor;
+
+uniform sampler2D source;
+uniform vec2 texelSize;     // of `source`
+
+vec3 Tap(float x, float y)
+{
+    return texture(source, vUV + vec2(x, y) * texelSize).rgb;
+}
+
+void main()
+{
+    vec3 corners = Tap(-1.0, -1.0) + Tap(1.0, -1.0) + Tap(-1.0, 1.0) + Tap(1.0, 1.0);
+    vec3 edges = Tap(0.0, -1.0) + Tap(-1.0, 0.0) + Tap(1.0, 0.0) + Tap(0.0, 1.0);
+    FragColor = vec4((corners + 2.0 * edges + 4.0 * Tap(0.0, 0.0)) / 16.0, 1.0);
+}
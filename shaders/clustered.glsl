@@ -0,0 +1,39 @@
+#include "frame_data.glsl"
+
+uniform samplerBuffer clusterLights;    // 2 texels per light: (position, radius), (color, 0)
+uniform usamplerBuffer clusterGrid;     // per cluster: (first index, light count)
+uniform usamplerBuffer clusterIndices;  // light indices grouped by cluster
+
+int ClusterIndex(vec3 worldPos)
+{
+    ivec3 size = ivec3(clusterSize.xyz);
+    float viewDepth = -(view * vec4(worldPos, 1.0)).z;
+    int slice = clamp(int(log(max(viewDepth, 1e-4)) * clusterParams.x + clusterParams.y), 0, size.z - 1);
+    ivec2 tile = min(ivec2(gl_FragCoord.xy / clusterParams.zw), size.xy - 1);
+    return (slice * size.y + tile.y) * size.x + tile.x;
+}
+
+// Blinn-Phong contribution of every point light in the fragment's cluster.
+vec3 ClusteredPointLights(vec3 worldPos, vec3 norm, vec3 viewDir, vec3 albedo)
+{
+    uvec2 range = texelFetch(clusterGrid, ClusterIndex(worldPos)).xy;
+    vec3 total = vec3(0.0);
+    for (uint i = 0u; i < range.y; ++i) {
+        int light = int(texelFetch(clusterIndices, int(range.x + i)).r);
+        vec4 posRadius = texelFetch(clusterLights, light * 2);
+        vec3 color = texelFetch(clusterLights, light * 2 + 1).rgb;
+
+        vec3 toLight = posRadius.xyz - worldPos;
+        float dist = length(toLight);
+        if (dist >= posRadius.w) continue;
+        vec3 L = toLight / dist;
+        // Inverse-square falloff windowed to reach zero at the radius.
+        float window = clamp(1.0 - pow(dist / posRadius.w, 4.0), 0.0, 1.0);
+        float attenuation = window * window / (dist * dist + 1.0);
+
+        float diff = max(dot(norm, L), 0.0);
+        float spec = pow(max(dot(norm, normalize(L + viewDir)), 0.0), 32.0);
+        total += (diff * albedo + spec) * color * attenuation;
+    }
+    return total;
+}
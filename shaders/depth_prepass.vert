@@ -0,0 +1,20 @@
+#version 330 core
+
+// Depth pre-pass over the position-only stream (Mesh::depthVao); paired with the empty
+// shadow_depth.frag. Variants: INSTANCED reads a per-instance transform on top of `model`.
+
+layout(location = 0) in vec3 aPos;
+#ifdef INSTANCED
+layout(location = 4) in mat4 aInstanceModel; // occupies locations 4-7
+#endif
+
+#include "frame_data.glsl"
+
+uniform mat4 model;
+
+#include "transform.glsl"
+
+void main()
+{
+    gl_Position = projection * view * WorldPosition(aPos);
+}
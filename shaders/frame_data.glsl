@@ -0,0 +1,14 @@
+// Per-frame camera, lighting and shadow data; bound once per frame at kFrameDataBinding.
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec4 lightDir;
+    vec4 lightColor;
+    vec4 viewPos;
+    float time;
+    mat4 lightSpace[4];
+    vec4 cascadeSplits;
+    vec4 shadowParams;
+    vec4 clusterSize;
+    vec4 clusterParams;
+};
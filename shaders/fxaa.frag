@@ -0,0 +1,53 @@
+#version 330 core
+
+// FXAA in the style of Lottes' FXAA 3 console variant: pixels with enough local luma contrast
+// are blurred along the edge direction estimated from their four diagonal neighbours.
+
+in vec2 vUV;
+
+out vec4 FragColor;
+
+uniform sampler2D source;
+uniform vec2 texelSize;
+
+const float kEdgeThreshold = 0.125;     // contrast relative to the local maximum
+const float kEdgeThresholdMin = 0.0312; // ignore contrast in very dark areas
+const float kReduceMul = 1.0 / 8.0;
+const float kReduceMin = 1.0 / 128.0;
+const float kSpanMax = 8.0;
+
+float Luma(vec3 color)
+{
+    return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
+void main()
+{
+    vec3 rgbM = texture(source, vUV).rgb;
+    float lumaNW = Luma(texture(source, vUV + vec2(-1.0, -1.0) * texelSize).rgb);
+    float lumaNE = Luma(texture(source, vUV + vec2(1.0, -1.0) * texelSize).rgb);
+    float lumaSW = Luma(texture(source, vUV + vec2(-1.0, 1.0) * texelSize).rgb);
+    float lumaSE = Luma(texture(source, vUV + vec2(1.0, 1.0) * texelSize).rgb);
+    float lumaM = Luma(rgbM);
+
+    float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+    if (lumaMax - lumaMin < max(kEdgeThresholdMin, lumaMax * kEdgeThreshold)) {
+        FragColor = vec4(rgbM, 1.0);
+        return;
+    }
+
+    // Gradient across the edge, rotated to point along it.
+    vec2 dir = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)), (lumaNW + lumaSW) - (lumaNE + lumaSE));
+    float dirReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * 0.25 * kReduceMul, kReduceMin);
+    float rcpDirMin = 1.0 / (min(abs(dir.x), abs(dir.y)) + dirReduce);
+    dir = clamp(dir * rcpDirMin, vec2(-kSpanMax), vec2(kSpanMax)) * texelSize;
+
+    vec3 rgbA = 0.5 * (texture(source, vUV + dir * (1.0 / 3.0 - 0.5)).rgb +
+                       texture(source, vUV + dir * (2.0 / 3.0 - 0.5)).rgb);
+    vec3 rgbB = rgbA * 0.5 + 0.25 * (texture(source, vUV - dir * 0.5).rgb +
+                                     texture(source, vUV + dir * 0.5).rgb);
+    // The wider blur overshot the local range: it crossed into another edge.
+    float lumaB = Luma(rgbB);
+    FragColor = vec4((lumaB < lumaMin || lumaB > lumaMax) ? rgbA : rgbB, 1.0);
+}
@@ -0,0 +1,11 @@
+#version 330 core
+
+// Overdraw view: every shaded fragment adds one step with additive blending, so a pixel
+// goes black -> red (4 layers) -> yellow (8) -> white (16) as more fragments land on it.
+
+out vec4 FragColor;
+
+void main()
+{
+    FragColor = vec4(0.25, 0.125, 0.0625, 1.0);
+}
@@ -0,0 +1,36 @@
+#version 330 core
+
+// HDR scene -> displayable color.
+// Variants: BLOOM adds the blurred bright pass, TONEMAP applies exposure and a filmic curve
+// (without it the HDR color is simply clamped, as when rendering straight to the window).
+
+in vec2 vUV;
+
+out vec4 FragColor;
+
+uniform sampler2D source;
+#ifdef BLOOM
+uniform sampler2D bloomTexture;
+uniform float bloomIntensity;
+#endif
+#ifdef TONEMAP
+uniform float exposure;
+
+// Narkowicz's fit of the ACES reference rendering transform.
+vec3 ACESFilm(vec3 x)
+{
+    return (x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14);
+}
+#endif
+
+void main()
+{
+    vec3 color = texture(source, vUV).rgb;
+#ifdef BLOOM
+    color += bloomIntensity * texture(bloomTexture, vUV).rgb;
+#endif
+#ifdef TONEMAP
+    color = ACESFilm(color * exposure);
+#endif
+    FragColor = vec4(clamp(color, 0.0, 1.0), 1.0);
+}
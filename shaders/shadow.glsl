@@ -0,0 +1,35 @@
+#include "frame_data.glsl"
+
+uniform sampler2DArrayShadow shadowMap;
+
+// Fraction of light reaching worldPos, filtered with a (2r+1)^2 PCF kernel.
+float ShadowFactor(vec3 worldPos, vec3 norm, vec3 light)
+{
+    int cascadeCount = int(shadowParams.x);
+    float viewDepth = -(view * vec4(worldPos, 1.0)).z;
+    int cascade = cascadeCount;
+    for (int i = 0; i < cascadeCount; ++i) {
+        if (viewDepth < cascadeSplits[i]) {
+            cascade = i;
+            break;
+        }
+    }
+    if (cascade == cascadeCount) return 1.0;
+
+    vec4 lightPos = lightSpace[cascade] * vec4(worldPos, 1.0);
+    vec3 proj = lightPos.xyz / lightPos.w * 0.5 + 0.5;
+    if (proj.z > 1.0) return 1.0;
+
+    // Grazing angles need a larger offset to avoid acne.
+    float bias = max(0.002 * (1.0 - dot(norm, light)), 0.0005);
+    int radius = int(shadowParams.y);
+    float texel = shadowParams.z;
+    float lit = 0.0;
+    for (int x = -radius; x <= radius; ++x) {
+        for (int y = -radius; y <= radius; ++y) {
+            lit += texture(shadowMap, vec4(proj.xy + vec2(x, y) * texel, float(cascade), proj.z - bias));
+        }
+    }
+    float taps = float((2 * radius + 1) * (2 * radius + 1));
+    return lit / taps;
+}
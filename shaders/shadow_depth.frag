@@ -0,0 +1,6 @@
+#version 330 core
+
+// Depth-only pass: no color attachment, depth is written by the rasterizer.
+void main()
+{
+}
@@ -0,0 +1,22 @@
+#version 330 core
+
+// Variants: INSTANCED reads a per-instance transform on top of `model`.
+
+layout(location = 0) in vec3 aPos;
+#ifdef INSTANCED
+layout(location = 4) in mat4 aInstanceModel; // occupies locations 4-7
+#endif
+
+#include "frame_data.glsl"
+
+uniform mat4 model;
+uniform int cascade;
+
+void main()
+{
+#ifdef INSTANCED
+    gl_Position = lightSpace[cascade] * model * aInstanceModel * vec4(aPos, 1.0);
+#else
+    gl_Position = lightSpace[cascade] * model * vec4(aPos, 1.0);
+#endif
+}
@@ -0,0 +1,15 @@
+// World-space vertex position, shared by every vertex shader that feeds the main depth buffer.
+// The shading pass tests against the depth pre-pass with GL_EQUAL, so both must compute
+// gl_Position from the same expression and mark it invariant.
+// Expects `model` (and `aInstanceModel` for INSTANCED) to be declared by the includer.
+
+invariant gl_Position;
+
+vec4 WorldPosition(vec3 pos)
+{
+#ifdef INSTANCED
+    return model * (aInstanceModel * vec4(pos, 1.0));
+#else
+    return model * vec4(pos, 1.0);
+#endif
+}